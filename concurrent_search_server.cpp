@@ -0,0 +1,106 @@
+#include "concurrent_search_server.h"
+
+ConcurrentSearchServer::ConcurrentSearchServer(SearchServer search_server) {
+    search_server.SetAutoMergeSegments(false);
+    version_.store(std::make_shared<const SearchServer>(std::move(search_server)));
+}
+
+ConcurrentSearchServer::~ConcurrentSearchServer() {
+    WaitForSegmentMerge();
+}
+
+std::shared_ptr<const SearchServer> ConcurrentSearchServer::GetVersion() const {
+    return version_.load();
+}
+
+size_t ConcurrentSearchServer::GetDocumentCount() const {
+    return GetVersion()->GetDocumentCount();
+}
+
+void ConcurrentSearchServer::AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
+    Modify([&](SearchServer& search_server) {
+        search_server.AddDocument(document_id, document, status, ratings);
+        });
+}
+
+void ConcurrentSearchServer::AddDocuments(const std::vector<DocumentToAdd>& documents) {
+    Modify([&](SearchServer& search_server) {
+        search_server.AddDocuments(documents);
+        });
+}
+
+void ConcurrentSearchServer::RemoveDocument(int document_id) {
+    Modify([&](SearchServer& search_server) {
+        search_server.RemoveDocument(document_id);
+        });
+}
+
+void ConcurrentSearchServer::RemoveDocuments(const std::vector<int>& document_ids) {
+    Modify([&](SearchServer& search_server) {
+        search_server.RemoveDocuments(document_ids);
+        });
+}
+
+void ConcurrentSearchServer::Compact() {
+    Modify([](SearchServer& search_server) {
+        search_server.Compact();
+        });
+}
+
+void ConcurrentSearchServer::WaitForSegmentMerge() {
+    std::future<void> merge_task;
+    {
+        std::lock_guard guard(merge_mutex_);
+        merge_task = std::move(merge_task_);
+    }
+    if (merge_task.valid()) {
+        merge_task.get();
+    }
+}
+
+bool ConcurrentSearchServer::ReserveSegmentMerge(const SearchServer& version) {
+    if (is_merge_running_ || !version.IsSegmentMergeNeeded()) {
+        return false;
+    }
+    is_merge_running_ = true;
+    return true;
+}
+
+//       . Ÿ    ,
+//     :         
+void ConcurrentSearchServer::StartSegmentMerge() {
+    std::lock_guard guard(merge_mutex_);
+    std::future<void> previous_task = std::exchange(merge_task_, GetVersion()->GetThreadPool().Submit([this] { RunSegmentMerges(); }));
+    if (previous_task.valid()) {
+        previous_task.get();
+    }
+}
+
+// ,    ,  .     ,
+//      .    ,   ,
+//  ,     :     ,   
+//       
+void ConcurrentSearchServer::RunSegmentMerges() {
+    try {
+        while (true) {
+            std::optional<SearchServer::SegmentMerge> merge = GetVersion()->PrepareSegmentMerge();
+            std::lock_guard guard(writer_mutex_);
+            if (!merge) {
+                if (version_.load()->IsSegmentMergeNeeded()) {
+                    continue;
+                }
+                is_merge_running_ = false;
+                return;
+            }
+            auto next_version = std::make_shared<SearchServer>(*version_.load());
+            if (next_version->ApplySegmentMerge(std::move(*merge))) {
+                version_.store(std::move(next_version));
+            }
+        }
+    }
+    catch (...) {
+        std::lock_guard guard(writer_mutex_);
+        is_merge_running_ = false;
+        throw;
+    }
+}
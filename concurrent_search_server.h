@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "document.h"
+#include "search_server.h"
+
+//     .     ,
+//          .    
+//    ,    .
+//      : ,  ,  ,  
+//  id   PersistentArray,        
+//      .       .
+//         :   
+//  ,         
+class ConcurrentSearchServer {
+public:
+    explicit ConcurrentSearchServer(SearchServer search_server = SearchServer());
+    ConcurrentSearchServer(const ConcurrentSearchServer&) = delete;
+    ConcurrentSearchServer& operator=(const ConcurrentSearchServer&) = delete;
+    ~ConcurrentSearchServer();
+
+    // ;      ,   .
+    //    MatchDocument   ,     
+    std::shared_ptr<const SearchServer> GetVersion() const;
+
+    template <typename... Args>
+    std::vector<Document> FindTopDocuments(Args&&... args) const {
+        return GetVersion()->FindTopDocuments(std::forward<Args>(args)...);
+    }
+
+    size_t GetDocumentCount() const;
+
+    void AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+    void AddDocuments(const std::vector<DocumentToAdd>& documents);
+    void RemoveDocument(int document_id);
+    void RemoveDocuments(const std::vector<int>& document_ids);
+    //      ;      
+    void Compact();
+
+    //    : update     .
+    // update  ,   .    
+    //  ,   ,     
+    template <typename Update>
+    void Modify(Update&& update);
+
+    //    ,   
+    void WaitForSegmentMerge();
+
+private:
+    std::mutex writer_mutex_;
+    std::atomic<std::shared_ptr<const SearchServer>> version_;
+    // :   writer_mutex_,   - merge_mutex_
+    bool is_merge_running_ = false;
+    std::mutex merge_mutex_;
+    std::future<void> merge_task_;
+
+    // true,    ,      ;   writer_mutex_
+    bool ReserveSegmentMerge(const SearchServer& version);
+    void StartSegmentMerge();
+    void RunSegmentMerges();
+};
+
+template <typename Update>
+void ConcurrentSearchServer::Modify(Update&& update) {
+    bool start_merge = false;
+    {
+        std::lock_guard guard(writer_mutex_);
+        auto next_version = std::make_shared<SearchServer>(*version_.load());
+        update(*next_version);
+        start_merge = ReserveSegmentMerge(*next_version);
+        version_.store(std::move(next_version));
+    }
+    //   :        
+    if (start_merge) {
+        StartSegmentMerge();
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+//,    ,       (,   ).
+//   ,      .     ,
+//     ,    - .
+//         .      
+//    ,       
+template <typename T>
+class CopyOnWriteArray {
+public:
+    CopyOnWriteArray() = default;
+
+    explicit CopyOnWriteArray(std::vector<T> elements)
+        : owned_(std::make_shared<std::vector<T>>(std::move(elements)))
+    {
+    }
+
+    static CopyOnWriteArray View(const T* data, size_t size) {
+        CopyOnWriteArray array;
+        array.view_data_ = data;
+        array.view_size_ = size;
+        array.is_view_ = true;
+        return array;
+    }
+
+    const T* begin() const {
+        if (is_view_) {
+            return view_data_;
+        }
+        return owned_ ? owned_->data() : nullptr;
+    }
+
+    const T* end() const {
+        return begin() + size();
+    }
+
+    size_t size() const {
+        if (is_view_) {
+            return view_size_;
+        }
+        return owned_ ? owned_->size() : 0;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    const T& operator[](size_t index) const {
+        return begin()[index];
+    }
+
+    const T& front() const {
+        return *begin();
+    }
+
+    bool IsView() const {
+        return is_view_;
+    }
+
+    //  ;         .
+    //        ,   ,
+    // ,      
+    std::vector<T>& Mutable() {
+        if (is_view_) {
+            owned_ = std::make_shared<std::vector<T>>(view_data_, view_data_ + view_size_);
+            view_data_ = nullptr;
+            view_size_ = 0;
+            is_view_ = false;
+        }
+        else if (!owned_) {
+            owned_ = std::make_shared<std::vector<T>>();
+        }
+        else if (owned_.use_count() > 1) {
+            owned_ = std::make_shared<std::vector<T>>(*owned_);
+        }
+        return *owned_;
+    }
+
+    void push_back(const T& value) {
+        Mutable().push_back(value);
+    }
+
+    void reserve(size_t capacity) {
+        Mutable().reserve(capacity);
+    }
+
+    //    .        
+    void ShrinkToFit() {
+        if (!is_view_ && owned_ && owned_.use_count() == 1) {
+            owned_->shrink_to_fit();
+        }
+    }
+
+private:
+    std::shared_ptr<std::vector<T>> owned_;
+    const T* view_data_ = nullptr;
+    size_t view_size_ = 0;
+    bool is_view_ = false;
+};
@@ -14,9 +14,11 @@
 #include "log_duration.h"
 #include "remove_duplicates.h"
 #include "process_queries.h"
+#include "concurrent_search_server.h"
 
 using namespace std;
 
+#include <algorithm>
 #include <execution>
 #include <random>
 #include <string>
@@ -86,6 +88,313 @@ void TestFindTopDocuments(string_view mark, SearchServer search_server, const st
     cout << word_count << endl;
 }
 
+//прежний побайтовый разбор из string_processing.cpp: поиск пробелов через find и отдельная проверка каждого слова
+vector<string_view> SplitIntoWordsScalar(string_view text) {
+    vector<string_view> result;
+    text.remove_prefix(min(text.find_first_not_of(" "), text.size()));
+    while (!text.empty()) {
+        size_t position_first_space = text.find(' ');
+        string_view tmp_substr = text.substr(0, position_first_space);
+        result.push_back(tmp_substr);
+        text.remove_prefix(tmp_substr.size());
+        text.remove_prefix(min(text.find_first_not_of(" "), text.size()));
+    }
+    return result;
+}
+
+bool IsValidWordScalar(string_view word) {
+    return none_of(word.begin(), word.end(), [](char c) {
+        return c >= '\0' && c < ' ';
+        });
+}
+
+void TestTokenizer(const vector<string>& documents, int repeat_count) {
+    size_t word_count = 0;
+    {
+        LOG_DURATION("tokenize scalar"s);
+        for (int repeat = 0; repeat < repeat_count; ++repeat) {
+            for (const string& document : documents) {
+                for (const string_view word : SplitIntoWordsScalar(document)) {
+                    word_count += IsValidWordScalar(word);
+                }
+            }
+        }
+    }
+    cout << word_count << endl;
+    word_count = 0;
+    {
+        LOG_DURATION("tokenize simd"s);
+        vector<string_view> words;
+        for (int repeat = 0; repeat < repeat_count; ++repeat) {
+            for (const string& document : documents) {
+                if (SplitIntoValidWords(document, words)) {
+                    word_count += words.size();
+                }
+            }
+        }
+    }
+    cout << word_count << endl;
+}
+
+//загрузка корпуса: цикл AddDocument против пакетного AddDocuments
+void TestAddDocuments(mt19937& generator, const vector<string>& dictionary, int document_count) {
+    const auto texts = GenerateQueries(generator, dictionary, document_count, 10);
+    vector<DocumentToAdd> batch;
+    batch.reserve(texts.size());
+    for (int id = 0; id < document_count; ++id) {
+        batch.push_back({ id, texts[id], DocumentStatus::ACTUAL, { 1, 2, 3 } });
+    }
+    cout << document_count << " documents" << endl;
+    {
+        SearchServer search_server(dictionary[0]);
+        LOG_DURATION("AddDocument loop"s);
+        for (const DocumentToAdd& document : batch) {
+            search_server.AddDocument(document.id, document.text, document.status, document.ratings);
+        }
+    }
+    {
+        SearchServer search_server(dictionary[0]);
+        LOG_DURATION("AddDocuments seq"s);
+        search_server.AddDocuments(execution::seq, batch);
+    }
+    {
+        SearchServer search_server(dictionary[0]);
+        LOG_DURATION("AddDocuments par"s);
+        search_server.AddDocuments(execution::par, batch);
+    }
+}
+
+//стоимость одного изменения ConcurrentSearchServer: каждое публикует новую версию, разделяющую с прежней неизменённые части,
+//поэтому время записи не должно расти с размером корпуса. Первые записи после загрузки не замеряются: они платят
+//за разбор освобождённых при загрузке временных блоков аллокатором, а не за копирование версии
+void TestConcurrentWrites(mt19937& generator, const vector<string>& dictionary, int document_count) {
+    const int write_count = 100;
+    const auto texts = GenerateQueries(generator, dictionary, document_count + 2 * write_count, 10);
+    vector<DocumentToAdd> batch;
+    batch.reserve(document_count);
+    for (int id = 0; id < document_count; ++id) {
+        batch.push_back({ id, texts[id], DocumentStatus::ACTUAL, { 1, 2, 3 } });
+    }
+    SearchServer search_server(dictionary[0]);
+    search_server.AddDocuments(batch);
+    ConcurrentSearchServer concurrent_server(move(search_server));
+    cout << document_count << " documents"s << endl;
+    for (int id = document_count; id < document_count + write_count; ++id) {
+        concurrent_server.AddDocument(id, texts[id], DocumentStatus::ACTUAL, { 1, 2, 3 });
+    }
+    {
+        LOG_DURATION("concurrent AddDocument x100"s);
+        for (int id = document_count + write_count; id < document_count + 2 * write_count; ++id) {
+            concurrent_server.AddDocument(id, texts[id], DocumentStatus::ACTUAL, { 1, 2, 3 });
+        }
+    }
+    {
+        LOG_DURATION("concurrent RemoveDocument x100"s);
+        for (int id = 0; id < document_count; id += document_count / write_count) {
+            concurrent_server.RemoveDocument(id);
+        }
+    }
+    concurrent_server.WaitForSegmentMerge();
+    cout << concurrent_server.GetDocumentCount() << " left"s << endl;
+}
+
+//массовое удаление: каждый второй документ по одному и пакетом, затем перестройка сегментов
+void TestRemoveDocuments(mt19937& generator, const vector<string>& dictionary, int document_count) {
+    const auto texts = GenerateQueries(generator, dictionary, document_count, 10);
+    vector<DocumentToAdd> batch;
+    vector<int> removed_ids;
+    for (int id = 0; id < document_count; ++id) {
+        batch.push_back({ id, texts[id], DocumentStatus::ACTUAL, { 1, 2, 3 } });
+        if (id % 2 == 0) {
+            removed_ids.push_back(id);
+        }
+    }
+    cout << document_count << " documents, removing " << removed_ids.size() << endl;
+    SearchServer search_server(dictionary[0]);
+    search_server.AddDocuments(batch);
+    {
+        SearchServer copy = search_server;
+        LOG_DURATION("RemoveDocument loop"s);
+        for (const int id : removed_ids) {
+            copy.RemoveDocument(id);
+        }
+    }
+    {
+        SearchServer copy = search_server;
+        copy.SetCompactionThreshold(2.);
+        {
+            LOG_DURATION("RemoveDocuments"s);
+            copy.RemoveDocuments(removed_ids);
+        }
+        LOG_DURATION("Compact"s);
+        copy.Compact();
+    }
+}
+
+//поиск дубликатов в корпусе, где каждый десятый документ повторяет набор слов одного из предыдущих
+void TestRemoveDuplicates(mt19937& generator, const vector<string>& dictionary, int document_count) {
+    auto texts = GenerateQueries(generator, dictionary, document_count, 10);
+    for (int id = 10; id < document_count; id += 10) {
+        texts[id] = texts[uniform_int_distribution<int>(0, id - 1)(generator)];
+    }
+    vector<DocumentToAdd> batch;
+    for (int id = 0; id < document_count; ++id) {
+        batch.push_back({ id, texts[id], DocumentStatus::ACTUAL, { 1, 2, 3 } });
+    }
+    SearchServer search_server(dictionary[0]);
+    search_server.AddDocuments(batch);
+    cout << document_count << " documents" << endl;
+    cout.clear(ios_base::badbit);
+    {
+        LOG_DURATION("RemoveDuplicates"s);
+        RemoveDuplicates(search_server);
+    }
+    cout.clear(ios_base::goodbit);
+    cout << search_server.GetDocumentCount() << " left" << endl;
+}
+
+//поиск почти одинаковых документов: каждый десятый документ повторяет один из предыдущих с одним добавленным словом
+void TestFindNearDuplicates(mt19937& generator, const vector<string>& dictionary, int document_count) {
+    auto texts = GenerateQueries(generator, dictionary, document_count, 10);
+    for (int id = 10; id < document_count; id += 10) {
+        texts[id] = texts[uniform_int_distribution<int>(0, id - 1)(generator)] + " "s + GenerateWord(generator, 10);
+    }
+    vector<DocumentToAdd> batch;
+    for (int id = 0; id < document_count; ++id) {
+        batch.push_back({ id, texts[id], DocumentStatus::ACTUAL, { 1, 2, 3 } });
+    }
+    SearchServer search_server(dictionary[0]);
+    search_server.AddDocuments(batch);
+    cout << document_count << " documents" << endl;
+    vector<NearDuplicateCluster> clusters;
+    {
+        LOG_DURATION("FindNearDuplicates"s);
+        clusters = FindNearDuplicates(search_server, 0.8);
+    }
+    cout << clusters.size() << " clusters" << endl;
+}
+
+//холодный старт: индексация корпуса против загрузки его снимка
+void TestSnapshotStartup(mt19937& generator, const vector<string>& dictionary, int document_count) {
+    const auto texts = GenerateQueries(generator, dictionary, document_count, 10);
+    const string query = GenerateQuery(generator, dictionary, 20);
+    const string path = "search_server_benchmark.snapshot"s;
+    vector<DocumentToAdd> batch;
+    for (int id = 0; id < document_count; ++id) {
+        batch.push_back({ id, texts[id], DocumentStatus::ACTUAL, { 1, 2, 3 } });
+    }
+    {
+        SearchServer search_server(dictionary[0]);
+        {
+            LOG_DURATION("index corpus"s);
+            search_server.AddDocuments(batch);
+        }
+        LOG_DURATION("save snapshot"s);
+        search_server.SaveSnapshot(path);
+    }
+    for (const auto verification : { SnapshotVerification::FULL, SnapshotVerification::STRUCTURE }) {
+        LOG_DURATION(verification == SnapshotVerification::FULL ? "load snapshot and query, full check"s : "load snapshot and query, structure check"s);
+        const SearchServer search_server = SearchServer::LoadSnapshot(path, verification);
+        cout << search_server.FindTopDocuments(query).size() << endl;
+    }
+    remove(path.c_str());
+}
+
+//пакет запросов: время разбора запроса заметная часть общей задержки коротких запросов
+void TestProcessQueriesBatch(string_view mark, const SearchServer& search_server, const vector<string>& queries) {
+    LOG_DURATION(std::string{ mark });
+    size_t document_count = 0;
+    for (const auto& documents : ProcessQueries(search_server, queries)) {
+        document_count += documents.size();
+    }
+    cout << document_count << endl;
+}
+
+//кэш выдачи на неравномерном потоке: девять запросов из десяти - из двухсот популярных
+void TestResultCache(mt19937& generator, const vector<string>& dictionary, SearchServer search_server) {
+    const auto hot_queries = GenerateQueries(generator, dictionary, 200, 7);
+    vector<string> queries = GenerateQueries(generator, dictionary, 20'000, 7);
+    for (string& query : queries) {
+        if (uniform_int_distribution<int>(0, 9)(generator) != 0) {
+            query = hot_queries[uniform_int_distribution<size_t>(0, hot_queries.size() - 1)(generator)];
+        }
+    }
+    TestProcessQueriesBatch("ProcessQueries without cache"s, search_server, queries);
+    auto cache = make_shared<ResultCache>(1000);
+    search_server.SetResultCache(cache);
+    TestProcessQueriesBatch("ProcessQueries with cache"s, search_server, queries);
+    cout << cache->GetHitCount() << " hits, "s << cache->GetMissCount() << " misses"s << endl;
+}
+
+//текст с частотами слов по закону Ципфа: слово с номером i встречается в (i + 1) раз реже первого
+string GenerateZipfText(mt19937& generator, const vector<string>& dictionary, int word_count) {
+    static discrete_distribution<size_t> word_distribution = [&dictionary] {
+        vector<double> weights;
+        for (size_t i = 0; i < dictionary.size(); ++i) {
+            weights.push_back(1. / (i + 1));
+        }
+        return discrete_distribution<size_t>(weights.begin(), weights.end());
+    }();
+    string text;
+    for (int i = 0; i < word_count; ++i) {
+        if (!text.empty()) {
+            text.push_back(' ');
+        }
+        text += dictionary[word_distribution(generator)];
+    }
+    return text;
+}
+
+//полный подсчёт релевантности против MAX_SCORE: время и число прочитанных записей постинг-листов на запрос
+void TestScoringModes(string_view mark, SearchServer search_server, const vector<string>& queries) {
+    for (const ScoringMode mode : { ScoringMode::EXHAUSTIVE, ScoringMode::MAX_SCORE }) {
+        search_server.SetScoringMode(mode);
+        const uint64_t visited_before = SearchServer::GetVisitedPostingCount();
+        double relevance_sum = 0.;
+        {
+            LOG_DURATION(std::string{ mark } + (mode == ScoringMode::EXHAUSTIVE ? " exhaustive"s : " max score"s));
+            for (const string& query : queries) {
+                for (const Document& document : search_server.FindTopDocuments(query)) {
+                    relevance_sum += document.relevance;
+                }
+            }
+        }
+        cout << (SearchServer::GetVisitedPostingCount() - visited_before) / queries.size() << " postings per query, relevance sum "s << relevance_sum << endl;
+    }
+}
+
+//память сжатых постинг-листов: запись без сжатия занимала 16 байт
+void TestPostingMemory(string_view mark, const SearchServer& search_server) {
+    const size_t posting_bytes = search_server.GetPostingMemoryUsage();
+    cout << mark << ": "s << posting_bytes << " posting bytes, "s << posting_bytes / search_server.GetDocumentCount() << " per document"s << endl;
+}
+
+//сопоставление запросов со всем корпусом: MatchDocument для каждого документа против обхода постинг-листов слов запросов
+void TestCorpusMatching(const SearchServer& search_server, const vector<string>& queries) {
+    {
+        LOG_DURATION("MatchDocument for each document"s);
+        size_t word_count = 0;
+        for (const string& query : queries) {
+            for (const int document_id : search_server) {
+                word_count += get<0>(search_server.MatchDocument(query, document_id)).size();
+            }
+        }
+        cout << word_count << " matched words"s << endl;
+    }
+    const auto test_policy = [&](const string& mark, const auto& policy) {
+        LOG_DURATION(mark);
+        size_t word_count = 0;
+        for (const string& query : queries) {
+            search_server.MatchDocuments(policy, query, [&](int, span<const string_view> words, DocumentStatus) {
+                word_count += words.size();
+                });
+        }
+        cout << word_count << " matched words"s << endl;
+    };
+    test_policy("MatchDocuments seq"s, execution::seq);
+    test_policy("MatchDocuments par"s, execution::par);
+}
+
 #define TEST_MD(policy) TestMatchDocument(#policy, search_server, query, execution::policy)
 #define TEST_FTD(policy) TestFindTopDocuments(#policy, search_server, query, execution::policy)
 
@@ -109,6 +418,46 @@ int main() {
         search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, { 1, 2, 3 });
     }
 
+    TEST_MD(seq);
+    TEST_MD(par);
     TEST_FTD(seq);
     TEST_FTD(par);
+
+    TestTokenizer(documents, 10);
+
+    const auto short_queries = GenerateQueries(generator, dictionary, 10'000, 7);
+    TestProcessQueriesBatch("ProcessQueries"s, search_server, short_queries);
+    TestResultCache(generator, dictionary, search_server);
+
+    TestPostingMemory("uniform corpus"s, search_server);
+    TestScoringModes("long queries"s, search_server, GenerateQueries(generator, dictionary, 100, 500));
+    TestScoringModes("short queries"s, search_server, short_queries);
+    {
+        vector<DocumentToAdd> batch;
+        vector<string> texts;
+        for (int id = 0; id < 100'000; ++id) {
+            texts.push_back(GenerateZipfText(generator, dictionary, uniform_int_distribution<int>(10, 70)(generator)));
+        }
+        for (int id = 0; id < 100'000; ++id) {
+            batch.push_back({ id, texts[id], DocumentStatus::ACTUAL, { id % 10 } });
+        }
+        SearchServer zipf_server(dictionary[0]);
+        zipf_server.AddDocuments(batch);
+        TestPostingMemory("zipf corpus"s, zipf_server);
+        TestCorpusMatching(zipf_server, GenerateQueries(generator, dictionary, 10, 7));
+        TestScoringModes("zipf short queries"s, zipf_server, GenerateQueries(generator, dictionary, 2'000, 7));
+    }
+
+    for (const int document_count : { 10'000, 100'000, 1'000'000 }) {
+        TestAddDocuments(generator, dictionary, document_count);
+    }
+    for (const int document_count : { 10'000, 100'000, 1'000'000 }) {
+        TestConcurrentWrites(generator, dictionary, document_count);
+    }
+
+    TestRemoveDocuments(generator, dictionary, 1'000'000);
+    TestRemoveDuplicates(generator, dictionary, 1'000'000);
+    TestFindNearDuplicates(generator, dictionary, 1'000'000);
+
+    TestSnapshotStartup(generator, dictionary, 1'000'000);
 }
\ No newline at end of file
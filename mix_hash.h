@@ -0,0 +1,11 @@
+#pragma once
+#include <cstdint>
+
+//  64-  ( splitmix64).     ,
+//MinHash-,      id 
+inline uint64_t MixHash(uint64_t value) {
+    value += 0x9e3779b97f4a7c15ull;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ull;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebull;
+    return value ^ (value >> 31);
+}
@@ -0,0 +1,104 @@
+#include "ordinal_map.h"
+#include "mix_hash.h"
+
+#include <algorithm>
+#include <bit>
+#include <vector>
+
+int OrdinalMap::Find(int id) const {
+    if (slots_.empty()) {
+        return NO_ORDINAL;
+    }
+    return slots_[FindSlot(id)].ordinal;
+}
+
+bool OrdinalMap::Insert(int id, int ordinal) {
+    if ((size_ + erased_count_ + 1) * 2 > slots_.size()) {
+        Rebuild(std::max<size_t>(16, std::bit_ceil((size_ + 1) * 4)));
+    }
+    const size_t slot = FindSlot(id);
+    if (slots_[slot].id == id) {
+        return false;
+    }
+    slots_.Mutable(slot) = { id, ordinal };
+    ++size_;
+    return true;
+}
+
+//       id   
+bool OrdinalMap::Erase(int id) {
+    if (slots_.empty()) {
+        return false;
+    }
+    const size_t slot = FindSlot(id);
+    if (slots_[slot].id != id) {
+        return false;
+    }
+    slots_.Mutable(slot) = { ERASED_ID, NO_ORDINAL };
+    --size_;
+    ++erased_count_;
+    return true;
+}
+
+void OrdinalMap::InsertBatch(std::vector<std::pair<int, int>> id_ordinals) {
+    if (id_ordinals.size() < size_) {
+        for (const auto& [id, ordinal] : id_ordinals) {
+            Insert(id, ordinal);
+        }
+        return;
+    }
+    ForEach([&](int id, int ordinal) {
+        id_ordinals.emplace_back(id, ordinal);
+        });
+    const size_t slot_count = std::max<size_t>(16, std::bit_ceil(id_ordinals.size() * 4));
+    Build(std::move(id_ordinals), slot_count);
+}
+
+bool OrdinalMap::Assign(std::vector<std::pair<int, int>> id_ordinals) {
+    const size_t slot_count = std::max<size_t>(16, std::bit_ceil(id_ordinals.size() * 4));
+    if (!Build(std::move(id_ordinals), slot_count)) {
+        *this = OrdinalMap();
+        return false;
+    }
+    return true;
+}
+
+//---private:
+
+size_t OrdinalMap::FindSlot(int id) const {
+    const size_t mask = slots_.size() - 1;
+    for (size_t slot = MixHash(static_cast<uint64_t>(id)) & mask;; slot = (slot + 1) & mask) {
+        const int slot_id = slots_[slot].id;
+        if (slot_id == id || slot_id == EMPTY_ID) {
+            return slot;
+        }
+    }
+}
+
+void OrdinalMap::Rebuild(size_t slot_count) {
+    std::vector<std::pair<int, int>> id_ordinals;
+    id_ordinals.reserve(size_);
+    ForEach([&](int id, int ordinal) {
+        id_ordinals.emplace_back(id, ordinal);
+        });
+    Build(std::move(id_ordinals), slot_count);
+}
+
+//    ,       
+bool OrdinalMap::Build(std::vector<std::pair<int, int>> id_ordinals, size_t slot_count) {
+    const size_t mask = slot_count - 1;
+    std::vector<Slot> slots(slot_count);
+    for (const auto& [id, ordinal] : id_ordinals) {
+        size_t slot = MixHash(static_cast<uint64_t>(id)) & mask;
+        for (; slots[slot].id != EMPTY_ID; slot = (slot + 1) & mask) {
+            if (slots[slot].id == id) {
+                return false;
+            }
+        }
+        slots[slot] = { id, ordinal };
+    }
+    slots_ = PersistentArray<Slot>(std::move(slots));
+    size_ = id_ordinals.size();
+    erased_count_ = 0;
+    return true;
+}
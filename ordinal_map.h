@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "persistent_array.h"
+
+//  id    :     
+// PersistentArray,     ,        .
+// ,       ;   O( id),
+//     
+class OrdinalMap {
+public:
+    static constexpr int NO_ORDINAL = -1;
+
+    size_t size() const {
+        return size_;
+    }
+
+    //    NO_ORDINAL
+    int Find(int id) const;
+    //false,  id  
+    bool Insert(int id, int ordinal);
+    //false,  id 
+    bool Erase(int id);
+    //   id,   ;      ,     
+    void InsertBatch(std::vector<std::pair<int, int>> id_ordinals);
+    //   (id,  ); false,  id ,   
+    bool Assign(std::vector<std::pair<int, int>> id_ordinals);
+
+    // function(id, ordinal)   id    
+    template <typename Function>
+    void ForEach(Function&& function) const {
+        slots_.ForEach([&](const Slot& slot) {
+            if (slot.id >= 0) {
+                function(slot.id, slot.ordinal);
+            }
+            });
+    }
+
+private:
+    static constexpr int EMPTY_ID = -1;
+    static constexpr int ERASED_ID = -2;
+
+    struct Slot {
+        int id = EMPTY_ID;
+        int ordinal = NO_ORDINAL;
+    };
+
+    PersistentArray<Slot> slots_;
+    size_t size_ = 0;
+    size_t erased_count_ = 0;
+
+    // id   ,    
+    size_t FindSlot(int id) const;
+    void Rebuild(size_t slot_count);
+    //   slot_count ; false,  id 
+    bool Build(std::vector<std::pair<int, int>> id_ordinals, size_t slot_count);
+};
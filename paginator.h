@@ -1,6 +1,14 @@
 // --------   Paginator    ----------
 #pragma once
+#include<algorithm>
+#include<deque>
 #include<iosfwd>
+#include<string>
+#include<string_view>
+#include<type_traits>
+#include<vector>
+
+#include "document.h"
 
 //     -    
 template <typename Iterator>
@@ -67,6 +75,124 @@ auto Paginate(const Container& c, size_t page_size) {
     return Paginator(c.begin(), c.end(), page_size);
 }
 
+// Paginator:            .
+// -  source(offset, count),  count     offset.
+//    ,      , 
+// P   O(log P)   ,   P
+template <typename PageSource>
+class LazyPaginator {
+public:
+    using Page = std::invoke_result_t<PageSource&, size_t, size_t>;
+
+    class PageIterator {
+    public:
+        PageIterator() = default;
+
+        PageIterator(LazyPaginator* paginator, size_t page_index)
+            :paginator_(paginator), page_index_(page_index)
+        {
+        }
+
+        const Page& operator*() const {
+            return paginator_->GetPage(page_index_);
+        }
+
+        PageIterator& operator++() {
+            ++page_index_;
+            return *this;
+        }
+
+        bool operator==(const PageIterator& other) const {
+            if (IsEnd() || other.IsEnd()) {
+                return IsEnd() && other.IsEnd();
+            }
+            return page_index_ == other.page_index_;
+        }
+
+        bool operator!=(const PageIterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        LazyPaginator* paginator_ = nullptr;
+        size_t page_index_ = 0;
+
+        // ,       
+        bool IsEnd() const {
+            if (paginator_ == nullptr) {
+                return true;
+            }
+            if (page_index_ > 0 && paginator_->GetPage(page_index_ - 1).size() < paginator_->GetPageSize()) {
+                return true;
+            }
+            return paginator_->GetPage(page_index_).empty();
+        }
+    };
+
+    LazyPaginator(PageSource source, size_t page_size)
+        :source_(std::move(source)), page_size_(page_size)
+    {
+    }
+
+    const Page& GetPage(size_t page_index) {
+        if (page_index >= pages_.size() && !is_exhausted_) {
+            FetchPages(std::max(page_index + 1, pages_.size() * 2));
+        }
+        return page_index < pages_.size() ? pages_[page_index] : empty_page_;
+    }
+
+    size_t GetPageSize() const {
+        return page_size_;
+    }
+
+    PageIterator begin() {
+        return PageIterator(this, 0);
+    }
+
+    PageIterator end() {
+        return PageIterator();
+    }
+
+private:
+    PageSource source_;
+    size_t page_size_ = 1u;
+    //     ; deque      
+    std::deque<Page> pages_;
+    //  ,    :   
+    bool is_exhausted_ = false;
+    Page empty_page_{};
+
+    //   pages_.size()  page_count       
+    void FetchPages(size_t page_count) {
+        const size_t count = (page_count - pages_.size()) * page_size_;
+        const Page results = source_(pages_.size() * page_size_, count);
+        is_exhausted_ = results.size() < count;
+        for (auto page_begin = results.begin(); page_begin != results.end();) {
+            const auto page_end = std::next(page_begin, std::min<size_t>(page_size_, std::distance(page_begin, results.end())));
+            pages_.emplace_back(page_begin, page_end);
+            page_begin = page_end;
+        }
+    }
+};
+
+//   :     FindTopDocuments  offset  count,
+//  N      .    ,
+//   P   O(log P)   
+template <typename Server, typename DocumentPredicate>
+auto PaginateQuery(const Server& server, std::string_view raw_query, size_t page_size, DocumentPredicate document_predicate) {
+    return LazyPaginator([&server, query = std::string(raw_query), document_predicate](size_t offset, size_t count) {
+        return server.FindTopDocuments(query, document_predicate, offset, count);
+        }, page_size);
+}
+
+//   ACTUAL;        ,   
+template <typename Server>
+auto PaginateQuery(const Server& server, std::string_view raw_query, size_t page_size) {
+    return LazyPaginator([&server, query = std::string(raw_query)](size_t offset, size_t count) {
+        return server.FindTopDocuments(query, DocumentStatus::ACTUAL, offset, count);
+        }, page_size);
+}
+
 //   IteratorRange
 template <typename Iterator>
 std::ostream& operator<<(std::ostream& os, const IteratorRange<Iterator> documents) {
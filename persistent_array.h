@@ -0,0 +1,171 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+//,     .      LEAF_SIZE,  -   
+// BRANCH_SIZE ,        .  
+//      ,     - : O(LEAF_SIZE + BRANCH_SIZE * )
+// O( ).     ,   CopyOnWriteArray;  ,  ,
+//       ( Mutable  ),     
+template <typename T>
+class PersistentArray {
+public:
+    //   :     ,     
+    static constexpr size_t LEAF_SIZE = std::max<size_t>(8, std::bit_floor(4096 / sizeof(T)));
+    static constexpr size_t BRANCH_SIZE = 64;
+
+    PersistentArray() = default;
+
+    explicit PersistentArray(std::vector<T> elements) {
+        resize(elements.size());
+        for (size_t index = 0; index < elements.size(); index += LEAF_SIZE) {
+            Leaf& leaf = MutableLeaf(index);
+            std::move(elements.begin() + index, elements.begin() + std::min(elements.size(), index + LEAF_SIZE), leaf.elements.begin());
+        }
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    const T& operator[](size_t index) const {
+        return GetLeaf(index).elements[index % LEAF_SIZE];
+    }
+
+    // ;         
+    T& Mutable(size_t index) {
+        return MutableLeaf(index).elements[index % LEAF_SIZE];
+    }
+
+    void push_back(T value) {
+        resize(size_ + 1);
+        Mutable(size_ - 1) = std::move(value);
+    }
+
+    //  [first, last),     
+    template <typename It>
+    void append(It first, It last) {
+        size_t index = size_;
+        resize(size_ + static_cast<size_t>(std::distance(first, last)));
+        while (first != last) {
+            Leaf& leaf = MutableLeaf(index);
+            for (size_t offset = index % LEAF_SIZE; offset < LEAF_SIZE && first != last; ++offset, ++first, ++index) {
+                leaf.elements[offset] = *first;
+            }
+        }
+    }
+
+    //  ,   - T()
+    void resize(size_t size) {
+        if (size <= size_) {
+            return;
+        }
+        while (GetCapacity() < size) {
+            auto branch = std::make_shared<Branch>();
+            branch->children[0] = std::move(root_);
+            root_ = std::move(branch);
+            ++height_;
+        }
+        //  ,      
+        const size_t old_size = size_;
+        size_ = size;
+        for (size_t index = old_size; index < size; index = (index / LEAF_SIZE + 1) * LEAF_SIZE) {
+            MutableLeaf(index);
+        }
+    }
+
+    // function(element)     ,     
+    template <typename Function>
+    void ForEach(Function&& function) const {
+        for (size_t index = 0; index < size_; index += LEAF_SIZE) {
+            const Leaf& leaf = GetLeaf(index);
+            std::for_each(leaf.elements.begin(), leaf.elements.begin() + std::min(LEAF_SIZE, size_ - index), function);
+        }
+    }
+
+    //     :   ,      ,
+    //    . ,    
+    class Reader {
+    public:
+        explicit Reader(const PersistentArray& array)
+            : array_(&array)
+        {
+        }
+
+        const T& operator[](size_t index) {
+            if (index - leaf_begin_ >= LEAF_SIZE) {
+                leaf_begin_ = index / LEAF_SIZE * LEAF_SIZE;
+                leaf_ = array_->GetLeaf(index).elements.data();
+            }
+            return leaf_[index - leaf_begin_];
+        }
+
+    private:
+        const PersistentArray* array_;
+        const T* leaf_ = nullptr;
+        size_t leaf_begin_ = static_cast<size_t>(-1) / 2;
+    };
+
+private:
+    static constexpr size_t LEAF_BITS = std::countr_zero(LEAF_SIZE);
+    static constexpr size_t BRANCH_BITS = std::countr_zero(BRANCH_SIZE);
+
+    struct Leaf {
+        std::array<T, LEAF_SIZE> elements{};
+    };
+    // -       ;    
+    struct Branch {
+        std::array<std::shared_ptr<void>, BRANCH_SIZE> children;
+    };
+
+    std::shared_ptr<void> root_;
+    size_t height_ = 0;
+    size_t size_ = 0;
+
+    size_t GetCapacity() const {
+        return LEAF_SIZE << (BRANCH_BITS * height_);
+    }
+
+    static size_t GetChildIndex(size_t index, size_t level) {
+        return (index >> (LEAF_BITS + BRANCH_BITS * (level - 1))) % BRANCH_SIZE;
+    }
+
+    const Leaf& GetLeaf(size_t index) const {
+        const void* node = root_.get();
+        for (size_t level = height_; level > 0; --level) {
+            node = static_cast<const Branch*>(node)->children[GetChildIndex(index, level)].get();
+        }
+        return *static_cast<const Leaf*>(node);
+    }
+
+    //  ,     - .    
+    //   ,   ,  ,      
+    template <typename Node>
+    static Node& MakeOwn(std::shared_ptr<void>& node) {
+        if (!node) {
+            node = std::make_shared<Node>();
+        }
+        else if (node.use_count() > 1) {
+            node = std::make_shared<Node>(*static_cast<const Node*>(node.get()));
+        }
+        return *static_cast<Node*>(node.get());
+    }
+
+    Leaf& MutableLeaf(size_t index) {
+        std::shared_ptr<void>* node = &root_;
+        for (size_t level = height_; level > 0; --level) {
+            node = &MakeOwn<Branch>(*node).children[GetChildIndex(index, level)];
+        }
+        return MakeOwn<Leaf>(*node);
+    }
+};
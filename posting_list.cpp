@@ -0,0 +1,436 @@
+#include "posting_list.h"
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SEARCH_SERVER_SSE2
+#endif
+
+namespace {
+
+constexpr size_t BLOCK_SIZE = PostingList::BLOCK_SIZE;
+constexpr size_t LANE_COUNT = 4;
+constexpr size_t ROW_COUNT = BLOCK_SIZE / LANE_COUNT;
+//      ,      ,      
+constexpr size_t PACKED_HEADER_SIZE = 3;
+
+size_t GetPackedSize(unsigned bits) {
+    return BLOCK_SIZE * bits / 8;
+}
+
+void AppendVarint(std::vector<uint8_t>& data, uint32_t value) {
+    while (value >= 0x80) {
+        data.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    data.push_back(static_cast<uint8_t>(value));
+}
+
+uint32_t ReadVarint(const uint8_t*& position) {
+    uint32_t value = 0;
+    for (unsigned shift = 0;; shift += 7) {
+        const uint8_t byte = *position++;
+        value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+}
+
+//     ,    end
+bool ReadVarintChecked(const uint8_t*& position, const uint8_t* end, uint32_t& value) {
+    value = 0;
+    for (unsigned shift = 0; shift < 35 && position != end; shift += 7) {
+        const uint8_t byte = *position++;
+        value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ReadVarintBlock(const uint8_t* position, int base_ordinal, size_t size, int* ordinals, uint32_t* counts, uint32_t* word_counts) {
+    int ordinal = base_ordinal;
+    for (size_t index = 0; index < size; ++index) {
+        ordinal += static_cast<int>(ReadVarint(position)) + 1;
+        ordinals[index] = ordinal;
+        counts[index] = ReadVarint(position) + 1;
+        word_counts[index] = ReadVarint(position) + 1;
+    }
+}
+
+// index    index % 4   index / 4.  -  bits-   32- ,
+// word  lane      word * 4 + lane,    SSE2    
+void PackValues(const uint32_t* values, unsigned bits, std::vector<uint8_t>& data) {
+    std::array<uint32_t, BLOCK_SIZE> words{};
+    for (size_t index = 0; index < BLOCK_SIZE && bits > 0; ++index) {
+        const size_t lane = index % LANE_COUNT;
+        const size_t bit = index / LANE_COUNT * bits;
+        const size_t word = bit / 32;
+        const size_t shift = bit % 32;
+        words[word * LANE_COUNT + lane] |= values[index] << shift;
+        if (shift + bits > 32) {
+            words[(word + 1) * LANE_COUNT + lane] |= values[index] >> (32 - shift);
+        }
+    }
+    const size_t offset = data.size();
+    data.resize(offset + GetPackedSize(bits));
+    std::memcpy(data.data() + offset, words.data(), GetPackedSize(bits));
+}
+
+unsigned GetBitWidth(const uint32_t* values) {
+    uint32_t combined = 0;
+    for (size_t index = 0; index < BLOCK_SIZE; ++index) {
+        combined |= values[index];
+    }
+    return static_cast<unsigned>(std::bit_width(combined));
+}
+
+#if defined(SEARCH_SERVER_SSE2)
+// row -  4 * row ... 4 * row + 3,     .     
+// ,      - ,    - 32   
+template <unsigned BITS, unsigned ROW>
+void UnpackRow(const uint8_t* data, uint32_t* values) {
+    constexpr unsigned word = ROW * BITS / 32;
+    constexpr unsigned shift = ROW * BITS % 32;
+    const __m128i* words = reinterpret_cast<const __m128i*>(data);
+    __m128i row = _mm_srli_epi32(_mm_loadu_si128(words + word), shift);
+    if constexpr (shift + BITS > 32) {
+        row = _mm_or_si128(row, _mm_slli_epi32(_mm_loadu_si128(words + word + 1), 32 - shift));
+    }
+    if constexpr (BITS < 32) {
+        row = _mm_and_si128(row, _mm_set1_epi32(static_cast<int>((1u << BITS) - 1)));
+    }
+    _mm_store_si128(reinterpret_cast<__m128i*>(values) + ROW, row);
+}
+
+template <unsigned BITS, unsigned... ROWS>
+void UnpackRows(const uint8_t* data, uint32_t* values, std::integer_sequence<unsigned, ROWS...>) {
+    (UnpackRow<BITS, ROWS>(data, values), ...);
+}
+
+template <unsigned BITS>
+void UnpackFixedWidth(const uint8_t* data, uint32_t* values) {
+    if constexpr (BITS == 0) {
+        std::fill(values, values + BLOCK_SIZE, 0u);
+    }
+    else {
+        UnpackRows<BITS>(data, values, std::make_integer_sequence<unsigned, ROW_COUNT>());
+    }
+}
+
+using UnpackFunction = void (*)(const uint8_t*, uint32_t*);
+
+template <unsigned... BITS>
+constexpr std::array<UnpackFunction, sizeof...(BITS)> MakeUnpackFunctions(std::integer_sequence<unsigned, BITS...>) {
+    return { &UnpackFixedWidth<BITS>... };
+}
+
+//     0  32 
+constexpr auto UNPACK_FUNCTIONS = MakeUnpackFunctions(std::make_integer_sequence<unsigned, 33>());
+
+void UnpackValues(const uint8_t* data, unsigned bits, uint32_t* values) {
+    UNPACK_FUNCTIONS[bits](data, values);
+}
+
+//         .
+// false,     (base_ordinal, last_ordinal]:     
+bool RestoreOrdinals(int* ordinals, int base_ordinal, int last_ordinal) {
+    __m128i* rows = reinterpret_cast<__m128i*>(ordinals);
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i low = _mm_set1_epi32(base_ordinal + 1);
+    const __m128i high = _mm_set1_epi32(last_ordinal);
+    __m128i previous = _mm_set1_epi32(base_ordinal);
+    __m128i out_of_range = _mm_setzero_si128();
+    for (size_t row = 0; row < ROW_COUNT; ++row) {
+        __m128i values = _mm_add_epi32(_mm_load_si128(rows + row), one);
+        values = _mm_add_epi32(values, _mm_slli_si128(values, 4));
+        values = _mm_add_epi32(values, _mm_slli_si128(values, 8));
+        values = _mm_add_epi32(values, previous);
+        _mm_store_si128(rows + row, values);
+        out_of_range = _mm_or_si128(out_of_range, _mm_or_si128(_mm_cmplt_epi32(values, low), _mm_cmpgt_epi32(values, high)));
+        previous = _mm_shuffle_epi32(values, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+    return _mm_movemask_epi8(out_of_range) == 0;
+}
+
+void RestoreCounts(uint32_t* counts) {
+    __m128i* rows = reinterpret_cast<__m128i*>(counts);
+    const __m128i one = _mm_set1_epi32(1);
+    for (size_t row = 0; row < ROW_COUNT; ++row) {
+        _mm_store_si128(rows + row, _mm_add_epi32(_mm_load_si128(rows + row), one));
+    }
+}
+
+//  32-   double: SSE2   ,     
+__m128d LoadUnsignedPair(const uint32_t* values) {
+    const __m128i sign = _mm_set1_epi32(INT32_MIN);
+    const __m128i pair = _mm_xor_si128(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(values)), sign);
+    return _mm_add_pd(_mm_cvtepi32_pd(pair), _mm_set1_pd(2147483648.0));
+}
+
+//   IEEE,   PostingList::ComputeTermFreq,     
+void RestoreTermFreqs(const uint32_t* counts, const uint32_t* word_counts, double* term_freqs) {
+    const __m128d one = _mm_set1_pd(1.0);
+    for (size_t index = 0; index < BLOCK_SIZE; index += 2) {
+        const __m128d count = LoadUnsignedPair(counts + index);
+        const __m128d word_count = LoadUnsignedPair(word_counts + index);
+        _mm_store_pd(term_freqs + index, _mm_mul_pd(count, _mm_div_pd(one, word_count)));
+    }
+}
+#else
+void UnpackValues(const uint8_t* data, unsigned bits, uint32_t* values) {
+    const uint32_t mask = bits == 32 ? ~uint32_t{ 0 } : (uint32_t{ 1 } << bits) - 1;
+    const auto read_word = [data](size_t index) {
+        uint32_t word;
+        std::memcpy(&word, data + index * sizeof(word), sizeof(word));
+        return word;
+    };
+    for (size_t index = 0; index < BLOCK_SIZE; ++index) {
+        if (bits == 0) {
+            values[index] = 0;
+            continue;
+        }
+        const size_t lane = index % LANE_COUNT;
+        const size_t bit = index / LANE_COUNT * bits;
+        const size_t word = bit / 32;
+        const size_t shift = bit % 32;
+        uint32_t value = read_word(word * LANE_COUNT + lane) >> shift;
+        if (shift + bits > 32) {
+            value |= read_word((word + 1) * LANE_COUNT + lane) << (32 - shift);
+        }
+        values[index] = value & mask;
+    }
+}
+
+bool RestoreOrdinals(int* ordinals, int base_ordinal, int last_ordinal) {
+    uint32_t ordinal = static_cast<uint32_t>(base_ordinal);
+    bool is_in_range = true;
+    for (size_t index = 0; index < BLOCK_SIZE; ++index) {
+        ordinal += static_cast<uint32_t>(ordinals[index]) + 1;
+        ordinals[index] = static_cast<int>(ordinal);
+        is_in_range &= ordinals[index] > base_ordinal && ordinals[index] <= last_ordinal;
+    }
+    return is_in_range;
+}
+
+void RestoreCounts(uint32_t* counts) {
+    for (size_t index = 0; index < BLOCK_SIZE; ++index) {
+        ++counts[index];
+    }
+}
+
+void RestoreTermFreqs(const uint32_t* counts, const uint32_t* word_counts, double* term_freqs) {
+    for (size_t index = 0; index < BLOCK_SIZE; ++index) {
+        term_freqs[index] = PostingList::ComputeTermFreq(counts[index], word_counts[index]);
+    }
+}
+#endif
+
+//  :  -   ,   -  
+void PackBlock(const PostingList::RawBlock& block, int base_ordinal, std::vector<uint8_t>& data) {
+    std::array<uint32_t, BLOCK_SIZE> deltas;
+    std::array<uint32_t, BLOCK_SIZE> counts;
+    std::array<uint32_t, BLOCK_SIZE> word_counts;
+    int previous_ordinal = base_ordinal;
+    for (size_t index = 0; index < BLOCK_SIZE; ++index) {
+        deltas[index] = static_cast<uint32_t>(block.ordinals[index] - previous_ordinal - 1);
+        counts[index] = block.counts[index] - 1;
+        word_counts[index] = block.word_counts[index] - 1;
+        previous_ordinal = block.ordinals[index];
+    }
+    for (const auto* values : { &deltas, &counts, &word_counts }) {
+        data.push_back(static_cast<uint8_t>(GetBitWidth(values->data())));
+    }
+    for (const auto* values : { &deltas, &counts, &word_counts }) {
+        PackValues(values->data(), GetBitWidth(values->data()), data);
+    }
+}
+
+} // namespace
+
+PostingList PostingList::View(const Block* blocks, const uint8_t* data, size_t data_size, size_t size) {
+    PostingList postings;
+    postings.blocks_ = CopyOnWriteArray<Block>::View(blocks, (size + BLOCK_SIZE - 1) / BLOCK_SIZE);
+    postings.data_ = CopyOnWriteArray<uint8_t>::View(data, data_size);
+    postings.size_ = size;
+    return postings;
+}
+
+bool PostingList::IsValid(int ordinal_end) const {
+    if (blocks_.size() != (size_ + BLOCK_SIZE - 1) / BLOCK_SIZE) {
+        return false;
+    }
+    for (size_t block = 0; block < blocks_.size(); ++block) {
+        const int base_ordinal = block > 0 ? blocks_[block - 1].last_ordinal : -1;
+        const int last_ordinal = blocks_[block].last_ordinal;
+        const size_t data_begin = blocks_[block].data_offset;
+        const size_t data_end = block + 1 < blocks_.size() ? blocks_[block + 1].data_offset : data_.size();
+        if (last_ordinal <= base_ordinal || last_ordinal >= ordinal_end || (block == 0 && data_begin != 0)
+            || data_begin >= data_end || data_end > data_.size()) {
+            return false;
+        }
+        const uint8_t* data = data_.begin() + data_begin;
+        const uint8_t* end = data_.begin() + data_end;
+        const size_t size = GetBlockSize(block);
+        if (size == BLOCK_SIZE) {
+            if (data_end - data_begin < PACKED_HEADER_SIZE) {
+                return false;
+            }
+            size_t packed_size = PACKED_HEADER_SIZE;
+            for (size_t field = 0; field < PACKED_HEADER_SIZE; ++field) {
+                if (data[field] > 32) {
+                    return false;
+                }
+                packed_size += GetPackedSize(data[field]);
+            }
+            if (packed_size != data_end - data_begin) {
+                return false;
+            }
+            continue;
+        }
+        //  ,     
+        int64_t ordinal = base_ordinal;
+        for (size_t index = 0; index < size; ++index) {
+            uint32_t delta, count, word_count;
+            if (!ReadVarintChecked(data, end, delta) || !ReadVarintChecked(data, end, count) || !ReadVarintChecked(data, end, word_count)) {
+                return false;
+            }
+            ordinal += int64_t{ delta } + 1;
+            if (ordinal > last_ordinal) {
+                return false;
+            }
+        }
+        if (ordinal != last_ordinal || data != end) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void PostingList::Append(int ordinal, uint32_t count, uint32_t word_count) {
+    std::vector<Block>& blocks = blocks_.Mutable();
+    std::vector<uint8_t>& data = data_.Mutable();
+    const int previous_ordinal = blocks.empty() ? -1 : blocks.back().last_ordinal;
+    if (size_ % BLOCK_SIZE == 0) {
+        blocks.push_back({ ordinal, static_cast<uint32_t>(data.size()) });
+    }
+    AppendVarint(data, static_cast<uint32_t>(ordinal - previous_ordinal - 1));
+    AppendVarint(data, count - 1);
+    AppendVarint(data, word_count - 1);
+    blocks.back().last_ordinal = ordinal;
+    ++size_;
+    if (size_ % BLOCK_SIZE != 0) {
+        return;
+    }
+    //       VByte
+    const int base_ordinal = blocks.size() > 1 ? blocks[blocks.size() - 2].last_ordinal : -1;
+    RawBlock block;
+    ReadVarintBlock(data.data() + blocks.back().data_offset, base_ordinal, BLOCK_SIZE, block.ordinals, block.counts, block.word_counts);
+    data.resize(blocks.back().data_offset);
+    PackBlock(block, base_ordinal, data);
+}
+
+size_t PostingList::FindBlock(int ordinal, size_t first) const {
+    const Block* position = blocks_.begin() + first;
+    const Block* end = blocks_.end();
+    if (position == end || position->last_ordinal >= ordinal) {
+        return first;
+    }
+    ptrdiff_t step = 1;
+    while (step < end - position && position[step].last_ordinal < ordinal) {
+        position += step;
+        step *= 2;
+    }
+    const Block* last = position + std::min(step, end - position);
+    return std::lower_bound(position + 1, last, ordinal, [](const Block& block, int value) { return block.last_ordinal < value; }) - blocks_.begin();
+}
+
+void PostingList::DecodeBlock(size_t block, DecodedBlock& decoded) const {
+    alignas(16) uint32_t counts[BLOCK_SIZE];
+    alignas(16) uint32_t word_counts[BLOCK_SIZE];
+    decoded.size = DecodeFields(block, decoded.ordinals, counts, word_counts);
+    if (decoded.size == BLOCK_SIZE) {
+        RestoreTermFreqs(counts, word_counts, decoded.term_freqs);
+        return;
+    }
+    for (size_t index = 0; index < decoded.size; ++index) {
+        decoded.term_freqs[index] = ComputeTermFreq(counts[index], word_counts[index]);
+    }
+}
+
+void PostingList::DecodeRawBlock(size_t block, RawBlock& raw) const {
+    raw.size = DecodeFields(block, raw.ordinals, raw.counts, raw.word_counts);
+}
+
+bool PostingList::Contains(int ordinal) const {
+    const size_t block = FindBlock(ordinal);
+    if (block == blocks_.size()) {
+        return false;
+    }
+    DecodedBlock decoded;
+    DecodeBlock(block, decoded);
+    return std::binary_search(decoded.ordinals, decoded.ordinals + decoded.size, ordinal);
+}
+
+void PostingCursor::Reset(const PostingList& postings, int ordinal) {
+    postings_ = &postings;
+    decoded_count_ = 0;
+    LoadBlock(postings.FindBlock(ordinal));
+    position_ = std::lower_bound(block_.ordinals, block_.ordinals + block_.size, ordinal) - block_.ordinals;
+}
+
+void PostingCursor::Seek(int ordinal) {
+    if (IsEnd() || GetOrdinal() >= ordinal) {
+        return;
+    }
+    if (postings_->GetLastOrdinal(block_index_) < ordinal) {
+        LoadBlock(postings_->FindBlock(ordinal, block_index_ + 1));
+    }
+    position_ = std::lower_bound(block_.ordinals + position_, block_.ordinals + block_.size, ordinal) - block_.ordinals;
+}
+
+//---private:
+
+size_t PostingList::DecodeFields(size_t block, int* ordinals, uint32_t* counts, uint32_t* word_counts) const {
+    const int base_ordinal = block > 0 ? blocks_[block - 1].last_ordinal : -1;
+    const uint8_t* data = data_.begin() + blocks_[block].data_offset;
+    const size_t size = GetBlockSize(block);
+    if (size < BLOCK_SIZE) {
+        ReadVarintBlock(data, base_ordinal, size, ordinals, counts, word_counts);
+        return size;
+    }
+    const unsigned ordinal_bits = data[0];
+    const unsigned count_bits = data[1];
+    const unsigned word_count_bits = data[2];
+    data += PACKED_HEADER_SIZE;
+    UnpackValues(data, ordinal_bits, reinterpret_cast<uint32_t*>(ordinals));
+    if (!RestoreOrdinals(ordinals, base_ordinal, blocks_[block].last_ordinal)) {
+        throw std::runtime_error("Posting list is corrupted");
+    }
+    data += GetPackedSize(ordinal_bits);
+    UnpackValues(data, count_bits, counts);
+    RestoreCounts(counts);
+    data += GetPackedSize(count_bits);
+    UnpackValues(data, word_count_bits, word_counts);
+    RestoreCounts(word_counts);
+    return size;
+}
+
+void PostingCursor::LoadBlock(size_t block_index) {
+    block_index_ = block_index;
+    position_ = 0;
+    block_.size = 0;
+    if (block_index < postings_->GetBlockCount()) {
+        postings_->DecodeBlock(block_index, block_);
+        decoded_count_ += block_.size;
+    }
+}
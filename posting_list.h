@@ -0,0 +1,207 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "copy_on_write_array.h"
+
+//-   :       TF     .
+//TF      -        -  
+//    ,    ,     .
+//     BLOCK_SIZE.     ,  -  .
+//    :   -    ,    
+// 32-     SSE2    .   
+//   VByte,     ;   .
+//   -       ,     .
+//      ,  CopyOnWriteArray
+class PostingList {
+public:
+    static constexpr size_t BLOCK_SIZE = 128;
+
+    // ;      
+    struct Block {
+        int last_ordinal = 0;
+        uint32_t data_offset = 0;
+    };
+
+    // 
+    struct DecodedBlock {
+        alignas(16) int ordinals[BLOCK_SIZE];
+        alignas(16) double term_freqs[BLOCK_SIZE];
+        size_t size = 0;
+    };
+
+    //     -         
+    struct RawBlock {
+        alignas(16) int ordinals[BLOCK_SIZE];
+        alignas(16) uint32_t counts[BLOCK_SIZE];
+        alignas(16) uint32_t word_counts[BLOCK_SIZE];
+        size_t size = 0;
+    };
+
+    //TF ,  count     word_count 
+    static double ComputeTermFreq(uint32_t count, uint32_t word_count) {
+        return count * (1.0 / word_count);
+    }
+
+    PostingList() = default;
+
+    //    ,    ; size -  
+    static PostingList View(const Block* blocks, const uint8_t* data, size_t data_size, size_t size);
+
+    //        :   , 
+    // ordinal_end,     32       ,  
+    //  .      
+    bool IsValid(int ordinal_end) const;
+
+    //ordinal      , 1 <= count <= word_count
+    void Append(int ordinal, uint32_t count, uint32_t word_count);
+
+    size_t size() const {
+        return size_;
+    }
+
+    bool empty() const {
+        return size_ == 0;
+    }
+
+    size_t GetBlockCount() const {
+        return blocks_.size();
+    }
+
+    int GetLastOrdinal(size_t block) const {
+        return blocks_[block].last_ordinal;
+    }
+
+    //    first,      ordinal; GetBlockCount(),   .
+    //    ,       
+    size_t FindBlock(int ordinal, size_t first = 0) const;
+
+    void DecodeBlock(size_t block, DecodedBlock& decoded) const;
+    void DecodeRawBlock(size_t block, RawBlock& raw) const;
+
+    bool Contains(int ordinal) const;
+
+    // ,     :    ,    
+    void ShrinkToFit() {
+        blocks_.ShrinkToFit();
+        data_.ShrinkToFit();
+    }
+
+    // function(ordinal, term_freq)      [ordinal_begin, ordinal_end)   ;
+    //   
+    template <typename Function>
+    size_t ForEach(int ordinal_begin, int ordinal_end, Function&& function) const;
+
+    template <typename Function>
+    size_t ForEach(Function&& function) const {
+        return ForEach(0, std::numeric_limits<int>::max(), function);
+    }
+
+    // function(ordinal, count, word_count)      
+    template <typename Function>
+    void ForEachRaw(Function&& function) const;
+
+    //     
+    size_t GetDataSize() const {
+        return blocks_.size() * sizeof(Block) + data_.size();
+    }
+
+    const CopyOnWriteArray<Block>& GetBlocks() const {
+        return blocks_;
+    }
+
+    const CopyOnWriteArray<uint8_t>& GetData() const {
+        return data_;
+    }
+
+private:
+    CopyOnWriteArray<Block> blocks_;
+    CopyOnWriteArray<uint8_t> data_;
+    size_t size_ = 0;
+
+    size_t GetBlockSize(size_t block) const {
+        return std::min(BLOCK_SIZE, size_ - block * BLOCK_SIZE);
+    }
+
+    //       ;     -  std::runtime_error
+    size_t DecodeFields(size_t block, int* ordinals, uint32_t* counts, uint32_t* word_counts) const;
+};
+
+//       :       
+class PostingCursor {
+public:
+    //        ordinal
+    void Reset(const PostingList& postings, int ordinal);
+
+    bool IsEnd() const {
+        return position_ == block_.size;
+    }
+
+    int GetOrdinal() const {
+        return block_.ordinals[position_];
+    }
+
+    double GetTermFreq() const {
+        return block_.term_freqs[position_];
+    }
+
+    void Next() {
+        if (++position_ == block_.size) {
+            LoadBlock(block_index_ + 1);
+        }
+    }
+
+    //      ordinal;      
+    void Seek(int ordinal);
+
+    // ,     Reset
+    size_t GetDecodedCount() const {
+        return decoded_count_;
+    }
+
+private:
+    const PostingList* postings_ = nullptr;
+    size_t block_index_ = 0;
+    size_t position_ = 0;
+    size_t decoded_count_ = 0;
+    PostingList::DecodedBlock block_;
+
+    //       ;      
+    void LoadBlock(size_t block_index);
+};
+
+template <typename Function>
+size_t PostingList::ForEach(int ordinal_begin, int ordinal_end, Function&& function) const {
+    DecodedBlock decoded;
+    size_t decoded_count = 0;
+    for (size_t block = FindBlock(ordinal_begin); block < blocks_.size(); ++block) {
+        //      
+        if (block > 0 && blocks_[block - 1].last_ordinal >= ordinal_end - 1) {
+            break;
+        }
+        DecodeBlock(block, decoded);
+        decoded_count += decoded.size;
+        const int* begin = decoded.ordinals;
+        const int* end = begin + decoded.size;
+        for (const int* position = std::lower_bound(begin, end, ordinal_begin); position != end; ++position) {
+            if (*position >= ordinal_end) {
+                return decoded_count;
+            }
+            function(*position, decoded.term_freqs[position - begin]);
+        }
+    }
+    return decoded_count;
+}
+
+template <typename Function>
+void PostingList::ForEachRaw(Function&& function) const {
+    RawBlock raw;
+    for (size_t block = 0; block < blocks_.size(); ++block) {
+        DecodeRawBlock(block, raw);
+        for (size_t index = 0; index < raw.size; ++index) {
+            function(raw.ordinals[index], raw.counts[index], raw.word_counts[index]);
+        }
+    }
+}
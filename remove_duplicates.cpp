@@ -1,46 +1,259 @@
-#include <map>
-#include <set>
-#include <vector>
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <numeric>
+#include <cstdint>
 #include <iostream>
-
 #include <vector>
 
 #include "remove_duplicates.h"
+#include "mix_hash.h"
+
+namespace {
+
+//   :    .
+//     ,     
+uint64_t ComputeTermSetFingerprint(const std::vector<TermDictionary::TermId>& term_ids) {
+	uint64_t hash = term_ids.size();
+	for (const TermDictionary::TermId term_id : term_ids) {
+		hash = MixHash(hash ^ term_id);
+	}
+	return hash;
+}
+
+//b- MinHash-:   -     ,     16 .
+//        2^-16     ,
+//     
+using MinHashSignature = std::array<uint16_t, NEAR_DUPLICATE_SIGNATURE_SIZE>;
+
+//- : h(x) =  32  (a * x + b)    ,  
+struct MinHashFunctions {
+	std::array<uint64_t, NEAR_DUPLICATE_SIGNATURE_SIZE> multipliers;
+	std::array<uint64_t, NEAR_DUPLICATE_SIGNATURE_SIZE> increments;
+
+	MinHashFunctions() {
+		for (size_t index = 0; index < NEAR_DUPLICATE_SIGNATURE_SIZE; ++index) {
+			multipliers[index] = MixHash(2 * index + 1) | 1;
+			increments[index] = MixHash(2 * index + 2);
+		}
+	}
+
+	void ComputeSignature(const std::vector<TermDictionary::TermId>& term_ids, MinHashSignature& signature) const {
+		std::array<uint32_t, NEAR_DUPLICATE_SIGNATURE_SIZE> minimums;
+		minimums.fill(UINT32_MAX);
+		for (const TermDictionary::TermId term_id : term_ids) {
+			const uint64_t value = MixHash(term_id);
+			for (size_t index = 0; index < NEAR_DUPLICATE_SIGNATURE_SIZE; ++index) {
+				minimums[index] = std::min(minimums[index], static_cast<uint32_t>((multipliers[index] * value + increments[index]) >> 32));
+			}
+		}
+		for (size_t index = 0; index < NEAR_DUPLICATE_SIGNATURE_SIZE; ++index) {
+			signature[index] = static_cast<uint16_t>(minimums[index]);
+		}
+	}
+};
+
+//    -      
+double EstimateJaccard(const MinHashSignature& lhs, const MinHashSignature& rhs) {
+	size_t match_count = 0;
+	for (size_t index = 0; index < NEAR_DUPLICATE_SIGNATURE_SIZE; ++index) {
+		match_count += lhs[index] == rhs[index];
+	}
+	return static_cast<double>(match_count) / NEAR_DUPLICATE_SIGNATURE_SIZE;
+}
+
+//     LSH.    ,       ;
+//  S- (1 /  )^(1 /   )    threshold ,
+//     threshold   
+size_t ChooseRowsPerBand(double threshold) {
+	size_t best_rows = 1;
+	for (size_t rows = 1; rows <= NEAR_DUPLICATE_SIGNATURE_SIZE; rows *= 2) {
+		const double band_count = static_cast<double>(NEAR_DUPLICATE_SIGNATURE_SIZE / rows);
+		if (std::pow(1. / band_count, 1. / rows) <= threshold) {
+			best_rows = rows;
+		}
+	}
+	return best_rows;
+}
+
+uint32_t FindRoot(std::vector<uint32_t>& parents, uint32_t index) {
+	while (parents[index] != index) {
+		parents[index] = parents[parents[index]];
+		index = parents[index];
+	}
+	return index;
+}
+
+} // namespace
 
 void RemoveDuplicates(SearchServer& search_server) {
-	std::map<std::set<std::string>, int> unic_documents;
+	const std::vector<int> ids(search_server.begin(), search_server.end());
+
+	//  ,       
+	std::vector<uint64_t> fingerprints(ids.size());
+	ThreadPool& thread_pool = search_server.GetThreadPool();
+	const size_t part_count = std::max<size_t>(1u, thread_pool.GetThreadCount() * 4);
+	const size_t part_size = ids.size() / part_count + 1;
+	thread_pool.ParallelFor(part_count, [&](size_t part) {
+		for (size_t index = part * part_size; index < std::min(ids.size(), (part + 1) * part_size); ++index) {
+			fingerprints[index] = ComputeTermSetFingerprint(search_server.GetDocumentTermIds(ids[index]));
+		}
+		});
+
+	//      -     :   
+	//      ,         .
+	//      
+	constexpr size_t NO_GROUP = static_cast<size_t>(-1);
+	std::vector<size_t> slots(std::bit_ceil(ids.size() * 2 + 1), NO_GROUP);
+	const size_t slot_mask = slots.size() - 1;
+	std::vector<size_t> next_group_documents(ids.size(), NO_GROUP);
+	std::vector<size_t> group_of(ids.size());
+	std::vector<int> group_min_ids;
+	for (size_t index = 0; index < ids.size(); ++index) {
+		size_t slot = fingerprints[index] & slot_mask;
+		while (slots[slot] != NO_GROUP && fingerprints[slots[slot]] != fingerprints[index]) {
+			slot = (slot + 1) & slot_mask;
+		}
+		size_t group_document = NO_GROUP;
+		if (slots[slot] == NO_GROUP) {
+			slots[slot] = index;
+		}
+		else {
+			const std::vector<TermDictionary::TermId> term_ids = search_server.GetDocumentTermIds(ids[index]);
+			size_t last_group_document = NO_GROUP;
+			for (size_t candidate = slots[slot]; candidate != NO_GROUP; candidate = next_group_documents[candidate]) {
+				if (search_server.GetDocumentTermIds(ids[candidate]) == term_ids) {
+					group_document = candidate;
+					break;
+				}
+				last_group_document = candidate;
+			}
+			if (group_document == NO_GROUP) {
+				next_group_documents[last_group_document] = index;
+			}
+		}
+		if (group_document == NO_GROUP) {
+			group_of[index] = group_min_ids.size();
+			group_min_ids.push_back(ids[index]);
+		}
+		else {
+			group_of[index] = group_of[group_document];
+			group_min_ids[group_of[index]] = std::min(group_min_ids[group_of[index]], ids[index]);
+		}
+	}
+
+	//       id,    
 	std::vector<int> ids_for_delete;
+	for (size_t index = 0; index < ids.size(); ++index) {
+		if (ids[index] != group_min_ids[group_of[index]]) {
+			ids_for_delete.push_back(ids[index]);
+			std::cout << "Found duplicate document id " << ids[index] << "\n";
+		}
+	}
+	search_server.RemoveDocuments(ids_for_delete);
+}
+
+std::vector<NearDuplicateCluster> FindNearDuplicates(const SearchServer& search_server, double threshold) {
+	const std::vector<int> ids(search_server.begin(), search_server.end());
+	ThreadPool& thread_pool = search_server.GetThreadPool();
 
-	bool isFirst = true;
-	for (const auto actual_id : search_server) {
-		//     
-		auto actual_document_map = search_server.GetWordFrequencies(actual_id);
-		std::set<std::string> actual_document;
-		for (auto it = actual_document_map.begin(); it != actual_document_map.end(); ++it) {
-			actual_document.insert(std::string(it->first));
+	//  ,       
+	static const MinHashFunctions hash_functions;
+	std::vector<MinHashSignature> signatures(ids.size());
+	std::vector<char> has_terms(ids.size());
+	const size_t part_count = std::max<size_t>(1u, thread_pool.GetThreadCount() * 4);
+	const size_t part_size = ids.size() / part_count + 1;
+	thread_pool.ParallelFor(part_count, [&](size_t part) {
+		for (size_t index = part * part_size; index < std::min(ids.size(), (part + 1) * part_size); ++index) {
+			const std::vector<TermDictionary::TermId> term_ids = search_server.GetDocumentTermIds(ids[index]);
+			has_terms[index] = !term_ids.empty();
+			hash_functions.ComputeSignature(term_ids, signatures[index]);
 		}
+		});
 
-		//  ,      unic_documents
-		if (isFirst) {
-			unic_documents.emplace(actual_document, actual_id);
-			isFirst = false;
-			continue;
+	//  -  :       ,      
+	//      .       ,
+	//            
+	const size_t rows_per_band = ChooseRowsPerBand(threshold);
+	const size_t band_count = NEAR_DUPLICATE_SIGNATURE_SIZE / rows_per_band;
+	std::vector<std::vector<std::pair<uint32_t, uint32_t>>> band_pairs(band_count);
+	thread_pool.ParallelFor(band_count, [&](size_t band) {
+		std::vector<std::pair<uint64_t, uint32_t>> band_keys;
+		band_keys.reserve(ids.size());
+		for (size_t index = 0; index < ids.size(); ++index) {
+			if (!has_terms[index]) {
+				continue;
+			}
+			uint64_t key = 0;
+			for (size_t row = band * rows_per_band; row < (band + 1) * rows_per_band; ++row) {
+				key = MixHash(key ^ signatures[index][row]);
+			}
+			band_keys.emplace_back(key, static_cast<uint32_t>(index));
 		}
-		bool isDuplicate = false;
+		std::sort(band_keys.begin(), band_keys.end());
+		const auto check_pair = [&](uint32_t lhs, uint32_t rhs) {
+			if (EstimateJaccard(signatures[lhs], signatures[rhs]) >= threshold) {
+				band_pairs[band].emplace_back(lhs, rhs);
+			}
+		};
+		for (size_t run_begin = 0; run_begin < band_keys.size();) {
+			size_t run_end = run_begin + 1;
+			for (; run_end < band_keys.size() && band_keys[run_end].first == band_keys[run_begin].first; ++run_end) {
+				check_pair(band_keys[run_begin].second, band_keys[run_end].second);
+				if (run_end - 1 != run_begin) {
+					check_pair(band_keys[run_end - 1].second, band_keys[run_end].second);
+				}
+			}
+			run_begin = run_end;
+		}
+		});
 
-		if (unic_documents.contains(actual_document)) {
-			actual_id > unic_documents.at(actual_document) ? ids_for_delete.push_back(actual_id) : ids_for_delete.push_back(unic_documents.at(actual_document));
-			actual_id > unic_documents.at(actual_document) ? std::cout << "Found duplicate document id " << actual_id << "\n" : std::cout << "Found duplicate document id " << unic_documents.at(actual_document) << "\n";
-			isDuplicate = true;
+	// -    
+	std::vector<uint32_t> parents(ids.size());
+	std::iota(parents.begin(), parents.end(), 0u);
+	for (const auto& pairs : band_pairs) {
+		for (const auto& [lhs, rhs] : pairs) {
+			const uint32_t lhs_root = FindRoot(parents, lhs);
+			const uint32_t rhs_root = FindRoot(parents, rhs);
+			if (lhs_root != rhs_root) {
+				parents[std::max(lhs_root, rhs_root)] = std::min(lhs_root, rhs_root);
+			}
+		}
+	}
+	std::vector<std::vector<uint32_t>> members(ids.size());
+	for (uint32_t index = 0; index < ids.size(); ++index) {
+		if (parents[index] != index || FindRoot(parents, index) != index) {
+			members[FindRoot(parents, index)].push_back(index);
 		}
+	}
 
-		//    ,    unic_documents
-		if (!isDuplicate) {
-			unic_documents.emplace(actual_document, actual_id);
+	std::vector<NearDuplicateCluster> clusters;
+	for (uint32_t root = 0; root < ids.size(); ++root) {
+		if (members[root].empty()) {
+			continue;
+		}
+		std::vector<uint32_t>& cluster_members = members[root];
+		cluster_members.push_back(root);
+		std::sort(cluster_members.begin(), cluster_members.end(), [&](uint32_t lhs, uint32_t rhs) { return ids[lhs] < ids[rhs]; });
+		NearDuplicateCluster& cluster = clusters.emplace_back();
+		for (const uint32_t index : cluster_members) {
+			cluster.document_ids.push_back(ids[index]);
+			cluster.similarities.push_back(EstimateJaccard(signatures[cluster_members.front()], signatures[index]));
 		}
 	}
-	//    id   ids_for_delete
-	for (const int id : ids_for_delete) {
-		search_server.RemoveDocument(id);
+	std::sort(clusters.begin(), clusters.end(), [](const NearDuplicateCluster& lhs, const NearDuplicateCluster& rhs) {
+		return lhs.document_ids.front() < rhs.document_ids.front();
+		});
+	return clusters;
+}
+
+std::vector<NearDuplicateCluster> RemoveNearDuplicates(SearchServer& search_server, double threshold) {
+	std::vector<NearDuplicateCluster> clusters = FindNearDuplicates(search_server, threshold);
+	std::vector<int> ids_for_delete;
+	for (const NearDuplicateCluster& cluster : clusters) {
+		ids_for_delete.insert(ids_for_delete.end(), cluster.document_ids.begin() + 1, cluster.document_ids.end());
 	}
-}
\ No newline at end of file
+	search_server.RemoveDocuments(ids_for_delete);
+	return clusters;
+}
@@ -1,4 +1,24 @@
 #pragma once
+#include <vector>
+
 #include "search_server.h"
 
-void RemoveDuplicates(SearchServer& search_server);
\ No newline at end of file
+// MinHash-   FindNearDuplicates
+const size_t NEAR_DUPLICATE_SIGNATURE_SIZE = 64;
+
+void RemoveDuplicates(SearchServer& search_server);
+
+//   : id       
+//      (  - 1)
+struct NearDuplicateCluster {
+    std::vector<int> document_ids;
+    std::vector<double> similarities;
+};
+
+// ,            threshold.
+//   MinHash-, -  LSH-     .
+//,     ,     .     
+std::vector<NearDuplicateCluster> FindNearDuplicates(const SearchServer& search_server, double threshold);
+
+//     ,     id,    
+std::vector<NearDuplicateCluster> RemoveNearDuplicates(SearchServer& search_server, double threshold);
@@ -1,36 +1,18 @@
 #include "request_queue.h"
 
 std::vector<Document> RequestQueue::AddFindRequest(std::string const& raw_query, DocumentStatus status) {
-    auto const& result = server_.FindTopDocuments(raw_query, status);
-    Distributor(raw_query, result.size());
-    return result;
+    //       ,   
+    return RecordRequest([&] { return server_.FindTopDocuments(raw_query, status); });
 }
 
 std::vector<Document> RequestQueue::AddFindRequest(std::string const& raw_query) {
-    auto const& result = server_.FindTopDocuments(raw_query);
-    Distributor(raw_query, result.size());
-    return result;
+    return AddFindRequest(raw_query, DocumentStatus::ACTUAL);
 }
 
 int RequestQueue::GetNoResultRequests() const {
-    return empty_results_;
+    return static_cast<int>(statistics_.GetNoResultRequests());
 }
 
-//---private:
-
-void RequestQueue::Distributor(std::string const& raw_query, size_t const size) {
-    //  requests_   1440 ,   ,
-    //      -    ,  --empty_results_
-    if (requests_.size() == min_in_day_) {
-        if (requests_.front().results_count == 0) {
-            --empty_results_;
-        }
-        requests_.pop_front();
-    }
-
-    // QueryResult  ,   size == 0, ++empty_results_
-    if (size == 0) {
-        ++empty_results_;
-    }
-    requests_.push_back(QueryResult{ raw_query, size });
-}
\ No newline at end of file
+QueryStatistics RequestQueue::GetStatistics() const {
+    return statistics_.Get();
+}
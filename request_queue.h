@@ -1,14 +1,18 @@
 #pragma once
+#include<chrono>
 #include<string>
 #include<vector>
-#include<deque>
 
 #include"document.h"
+#include"request_statistics.h"
 #include"search_server.h"
 
+//       .       
 class RequestQueue {
 public:
-    explicit RequestQueue(SearchServer const& search_server) : server_(search_server) {
+    explicit RequestQueue(SearchServer const& search_server, size_t window_size = 1440, StatisticsWindow window = StatisticsWindow::REQUESTS)
+        : server_(search_server)
+        , statistics_(window_size, window) {
     }
 
     template <typename DocumentPredicate>
@@ -20,23 +24,28 @@ public:
 
     int GetNoResultRequests() const;
 
+    QueryStatistics GetStatistics() const;
+
 private:
     const SearchServer& server_;
-    struct QueryResult {
-        std::string query;
-        size_t results_count;
-    };
-    std::deque<QueryResult> requests_;
-    const static int min_in_day_ = 1440;
-    int empty_results_ = 0;
-
-    void Distributor(std::string const& raw_query, size_t const size);
+    RequestStatistics statistics_;
+
+    //  search()     
+    template <typename Search>
+    std::vector<Document> RecordRequest(Search search);
 };
 
 
 template <typename DocumentPredicate>
 std::vector<Document> RequestQueue::AddFindRequest(const std::string& raw_query, DocumentPredicate document_predicate) {
-    auto const& result = server_.FindTopDocuments(raw_query, document_predicate);
-    Distributor(raw_query, result.size());
+    return RecordRequest([&] { return server_.FindTopDocuments(raw_query, document_predicate); });
+}
+
+template <typename Search>
+std::vector<Document> RequestQueue::RecordRequest(Search search) {
+    const auto start = RequestStatistics::Clock::now();
+    auto result = search();
+    const auto finish = RequestStatistics::Clock::now();
+    statistics_.Record(result.size(), finish - start, finish);
     return result;
-}
\ No newline at end of file
+}
@@ -0,0 +1,160 @@
+#include "request_statistics.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+const uint64_t VALID_RECORD = 1ull << 63;
+const int64_t RESETTING = INT64_MIN;
+
+size_t GetLatencyBucket(RequestStatistics::Clock::duration latency) {
+    const auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+    if (microseconds < 2) {
+        return 0;
+    }
+    return std::min<size_t>(std::bit_width(static_cast<uint64_t>(microseconds)) - 1, LATENCY_BUCKET_COUNT - 1);
+}
+
+size_t GetHitBucket(size_t results_count) {
+    return std::min(results_count, HIT_BUCKET_COUNT - 1);
+}
+
+int64_t GetMinute(RequestStatistics::Clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::minutes>(time.time_since_epoch()).count();
+}
+
+} // namespace
+
+std::chrono::microseconds QueryStatistics::GetLatencyPercentile(double percentile) const {
+    int64_t total = 0;
+    for (const int64_t count : latency_histogram) {
+        total += count;
+    }
+    if (total == 0) {
+        return std::chrono::microseconds(0);
+    }
+    const int64_t target = std::max<int64_t>(1, static_cast<int64_t>(std::ceil(percentile * total)));
+    int64_t cumulative = 0;
+    for (size_t bucket = 0; bucket < LATENCY_BUCKET_COUNT; ++bucket) {
+        cumulative += latency_histogram[bucket];
+        if (cumulative >= target) {
+            return std::chrono::microseconds(int64_t{ 2 } << bucket);
+        }
+    }
+    return std::chrono::microseconds(int64_t{ 2 } << (LATENCY_BUCKET_COUNT - 1));
+}
+
+RequestStatistics::RequestStatistics(size_t window_size, StatisticsWindow window)
+    : window_(window)
+    , window_size_(window_size) {
+    if (window_size_ == 0) {
+        throw std::invalid_argument("Statistics window must not be empty");
+    }
+    if (window_ == StatisticsWindow::REQUESTS) {
+        records_ = std::make_unique<std::atomic<uint64_t>[]>(window_size_);
+    }
+    else {
+        minute_buckets_ = std::make_unique<MinuteBucket[]>(window_size_);
+    }
+}
+
+void RequestStatistics::Record(size_t results_count, Clock::duration latency, Clock::time_point time) {
+    const size_t latency_bucket = GetLatencyBucket(latency);
+    const size_t hit_bucket = GetHitBucket(results_count);
+    if (window_ == StatisticsWindow::REQUESTS) {
+        //    ,    -      
+        const uint64_t record = VALID_RECORD | latency_bucket | (hit_bucket << 8);
+        const uint64_t slot = next_record_.fetch_add(1, std::memory_order_relaxed) % window_size_;
+        const uint64_t evicted = records_[slot].exchange(record, std::memory_order_relaxed);
+        window_counters_.Add(latency_bucket, hit_bucket, 1);
+        if (evicted & VALID_RECORD) {
+            window_counters_.Add(evicted & 0xff, (evicted >> 8) & 0xff, -1);
+        }
+        return;
+    }
+    if (MinuteBucket* bucket = AcquireMinuteBucket(GetMinute(time))) {
+        bucket->counters.Add(latency_bucket, hit_bucket, 1);
+    }
+}
+
+QueryStatistics RequestStatistics::Get(Clock::time_point time) const {
+    QueryStatistics statistics;
+    if (window_ == StatisticsWindow::REQUESTS) {
+        window_counters_.AddTo(statistics);
+        return statistics;
+    }
+    const int64_t minute = GetMinute(time);
+    for (size_t index = 0; index < window_size_; ++index) {
+        const int64_t bucket_minute = minute_buckets_[index].minute.load(std::memory_order_acquire);
+        if (bucket_minute != RESETTING && bucket_minute > minute - static_cast<int64_t>(window_size_) && bucket_minute <= minute) {
+            minute_buckets_[index].counters.AddTo(statistics);
+        }
+    }
+    return statistics;
+}
+
+int64_t RequestStatistics::GetNoResultRequests(Clock::time_point time) const {
+    if (window_ == StatisticsWindow::REQUESTS) {
+        return window_counters_.no_result_count.load(std::memory_order_relaxed);
+    }
+    return Get(time).no_result_count;
+}
+
+//---private:
+
+void RequestStatistics::Counters::Add(size_t latency_bucket, size_t hit_bucket, int64_t delta) {
+    request_count.fetch_add(delta, std::memory_order_relaxed);
+    if (hit_bucket == 0) {
+        no_result_count.fetch_add(delta, std::memory_order_relaxed);
+    }
+    latency_histogram[latency_bucket].fetch_add(delta, std::memory_order_relaxed);
+    hit_histogram[hit_bucket].fetch_add(delta, std::memory_order_relaxed);
+}
+
+void RequestStatistics::Counters::AddTo(QueryStatistics& statistics) const {
+    statistics.request_count += request_count.load(std::memory_order_relaxed);
+    statistics.no_result_count += no_result_count.load(std::memory_order_relaxed);
+    for (size_t bucket = 0; bucket < LATENCY_BUCKET_COUNT; ++bucket) {
+        statistics.latency_histogram[bucket] += latency_histogram[bucket].load(std::memory_order_relaxed);
+    }
+    for (size_t bucket = 0; bucket < HIT_BUCKET_COUNT; ++bucket) {
+        statistics.hit_histogram[bucket] += hit_histogram[bucket].load(std::memory_order_relaxed);
+    }
+}
+
+void RequestStatistics::Counters::Reset() {
+    request_count.store(0, std::memory_order_relaxed);
+    no_result_count.store(0, std::memory_order_relaxed);
+    for (auto& count : latency_histogram) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    for (auto& count : hit_histogram) {
+        count.store(0, std::memory_order_relaxed);
+    }
+}
+
+RequestStatistics::MinuteBucket* RequestStatistics::AcquireMinuteBucket(int64_t minute) {
+    MinuteBucket& bucket = minute_buckets_[static_cast<uint64_t>(minute) % window_size_];
+    int64_t bucket_minute = bucket.minute.load(std::memory_order_acquire);
+    while (bucket_minute != minute) {
+        if (bucket_minute == RESETTING) {
+            //        ,    
+            std::this_thread::yield();
+            bucket_minute = bucket.minute.load(std::memory_order_acquire);
+        }
+        else if (bucket_minute > minute) {
+            //  :      
+            return nullptr;
+        }
+        else if (bucket.minute.compare_exchange_weak(bucket_minute, RESETTING, std::memory_order_acquire)) {
+            bucket.counters.Reset();
+            bucket.minute.store(minute, std::memory_order_release);
+            return &bucket;
+        }
+    }
+    return &bucket;
+}
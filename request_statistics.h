@@ -0,0 +1,75 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+//   :     
+enum class StatisticsWindow {
+    REQUESTS,
+    MINUTES,
+};
+
+//   :  i     [2^i, 2^(i+1)) ,  0 -  2 
+const size_t LATENCY_BUCKET_COUNT = 32;
+//    :  i    i ,  -   
+const size_t HIT_BUCKET_COUNT = 17;
+
+//      
+struct QueryStatistics {
+    int64_t request_count = 0;
+    int64_t no_result_count = 0;
+    std::array<int64_t, LATENCY_BUCKET_COUNT> latency_histogram = {};
+    std::array<int64_t, HIT_BUCKET_COUNT> hit_histogram = {};
+
+    //  ,     percentile  ( 0  1)
+    std::chrono::microseconds GetLatencyPercentile(double percentile) const;
+};
+
+//    . Record  Get      :
+// -     .    -    ,
+//          .    -   ,
+//     .    ,      
+class RequestStatistics {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit RequestStatistics(size_t window_size = 1440, StatisticsWindow window = StatisticsWindow::REQUESTS);
+
+    void Record(size_t results_count, Clock::duration latency, Clock::time_point time = Clock::now());
+
+    QueryStatistics Get(Clock::time_point time = Clock::now()) const;
+
+    int64_t GetNoResultRequests(Clock::time_point time = Clock::now()) const;
+
+private:
+    struct Counters {
+        std::atomic<int64_t> request_count = 0;
+        std::atomic<int64_t> no_result_count = 0;
+        std::array<std::atomic<int64_t>, LATENCY_BUCKET_COUNT> latency_histogram = {};
+        std::array<std::atomic<int64_t>, HIT_BUCKET_COUNT> hit_histogram = {};
+
+        void Add(size_t latency_bucket, size_t hit_bucket, int64_t delta);
+        void AddTo(QueryStatistics& statistics) const;
+        void Reset();
+    };
+
+    // , minute -        RESETTING,   
+    struct MinuteBucket {
+        std::atomic<int64_t> minute = -1;
+        Counters counters;
+    };
+
+    const StatisticsWindow window_;
+    const size_t window_size_;
+    std::atomic<uint64_t> next_record_ = 0;
+    //  :   ,  VALID_RECORD   
+    std::unique_ptr<std::atomic<uint64_t>[]> records_;
+    Counters window_counters_;
+    //  : window_size_  -    window_size_ - 1 
+    std::unique_ptr<MinuteBucket[]> minute_buckets_;
+
+    //  minute,   ; nullptr,       
+    MinuteBucket* AcquireMinuteBucket(int64_t minute);
+};
@@ -0,0 +1,123 @@
+#include "result_cache.h"
+#include "mix_hash.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+const size_t MAX_SHARD_COUNT = 16;
+//  ,        
+const size_t MIN_SHARD_CAPACITY = 16;
+
+} // namespace
+
+ResultCache::ResultCache(size_t capacity) {
+    if (capacity == 0) {
+        throw std::invalid_argument("Result cache capacity must be positive");
+    }
+    shard_count_ = std::clamp<size_t>(capacity / MIN_SHARD_CAPACITY, 1, MAX_SHARD_COUNT);
+    shards_ = std::make_unique<Shard[]>(shard_count_);
+    for (size_t index = 0; index < shard_count_; ++index) {
+        shards_[index].capacity = capacity / shard_count_ + (index < capacity % shard_count_ ? 1 : 0);
+        shards_[index].entries.reserve(shards_[index].capacity);
+    }
+}
+
+std::optional<std::vector<Document>> ResultCache::Find(const ResultCacheKey& key) {
+    const size_t hash = KeyHash{}(key);
+    Shard& shard = GetShard(hash);
+    {
+        std::lock_guard guard(shard.mutex);
+        const auto slot = shard.slots.find(key);
+        if (slot != shard.slots.end()) {
+            Entry& entry = shard.entries[slot->second];
+            entry.is_referenced = true;
+            hit_count_.fetch_add(1, std::memory_order_relaxed);
+            return entry.documents;
+        }
+    }
+    miss_count_.fetch_add(1, std::memory_order_relaxed);
+    return std::nullopt;
+}
+
+void ResultCache::Insert(ResultCacheKey key, std::vector<Document> documents) {
+    const size_t hash = KeyHash{}(key);
+    Shard& shard = GetShard(hash);
+    std::lock_guard guard(shard.mutex);
+    //           
+    if (const auto slot = shard.slots.find(key); slot != shard.slots.end()) {
+        shard.entries[slot->second].documents = std::move(documents);
+        return;
+    }
+
+    size_t index = shard.entries.size();
+    if (index < shard.capacity) {
+        shard.entries.emplace_back();
+    }
+    else {
+        //    ,         
+        while (shard.entries[shard.clock_hand].is_referenced) {
+            shard.entries[shard.clock_hand].is_referenced = false;
+            shard.clock_hand = (shard.clock_hand + 1) % shard.entries.size();
+        }
+        index = shard.clock_hand;
+        shard.clock_hand = (shard.clock_hand + 1) % shard.entries.size();
+        //   : ,    ,       
+        //    
+        shard.slots.erase(shard.slots.find(*shard.entries[index].key));
+    }
+    const auto slot = shard.slots.emplace(std::move(key), index).first;
+    Entry& entry = shard.entries[index];
+    entry.key = &slot->first;
+    entry.documents = std::move(documents);
+    entry.is_referenced = false;
+}
+
+uint64_t ResultCache::GetHitCount() const {
+    return hit_count_.load(std::memory_order_relaxed);
+}
+
+uint64_t ResultCache::GetMissCount() const {
+    return miss_count_.load(std::memory_order_relaxed);
+}
+
+size_t ResultCache::GetSize() const {
+    size_t size = 0;
+    for (size_t index = 0; index < shard_count_; ++index) {
+        std::lock_guard guard(shards_[index].mutex);
+        size += shards_[index].entries.size();
+    }
+    return size;
+}
+
+void ResultCache::Clear() {
+    for (size_t index = 0; index < shard_count_; ++index) {
+        Shard& shard = shards_[index];
+        std::lock_guard guard(shard.mutex);
+        shard.slots.clear();
+        shard.entries.clear();
+        shard.clock_hand = 0;
+    }
+}
+
+//---private:
+
+size_t ResultCache::KeyHash::operator()(const ResultCacheKey& key) const {
+    uint64_t hash = MixHash(key.corpus_generation ^ (static_cast<uint64_t>(key.status) << 56));
+    hash = MixHash(hash ^ key.offset);
+    hash = MixHash(hash ^ key.count);
+    hash = MixHash(hash ^ key.plus_words.size());
+    for (const TermDictionary::TermId term_id : key.plus_words) {
+        hash = MixHash(hash ^ term_id);
+    }
+    for (const TermDictionary::TermId term_id : key.minus_words) {
+        hash = MixHash(hash ^ term_id);
+    }
+    return static_cast<size_t>(hash);
+}
+
+ResultCache::Shard& ResultCache::GetShard(size_t hash) const {
+    //      ,    
+    return shards_[(hash >> 32) % shard_count_];
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "document.h"
+#include "term_dictionary.h"
+
+//  :   (  -  -    ),
+// ,     .      
+//   ,           
+struct ResultCacheKey {
+    std::vector<TermDictionary::TermId> plus_words;
+    std::vector<TermDictionary::TermId> minus_words;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    size_t offset = 0;
+    size_t count = 0;
+    uint64_t corpus_generation = 0;
+
+    bool operator==(const ResultCacheKey& other) const = default;
+};
+
+//    FindTopDocuments     CLOCK.
+//      ,         .
+//     :     ,  CLOCK   
+class ResultCache {
+public:
+    explicit ResultCache(size_t capacity);
+
+    std::optional<std::vector<Document>> Find(const ResultCacheKey& key);
+    void Insert(ResultCacheKey key, std::vector<Document> documents);
+
+    uint64_t GetHitCount() const;
+    uint64_t GetMissCount() const;
+    size_t GetSize() const;
+    void Clear();
+
+private:
+    struct KeyHash {
+        size_t operator()(const ResultCacheKey& key) const;
+    };
+
+    struct Entry {
+        //     slots
+        const ResultCacheKey* key = nullptr;
+        std::vector<Document> documents;
+        bool is_referenced = false;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        size_t capacity = 0;
+        //   entries  
+        std::unordered_map<ResultCacheKey, size_t, KeyHash> slots;
+        std::vector<Entry> entries;
+        size_t clock_hand = 0;
+    };
+
+    std::unique_ptr<Shard[]> shards_;
+    size_t shard_count_ = 0;
+    std::atomic<uint64_t> hit_count_ = 0;
+    std::atomic<uint64_t> miss_count_ = 0;
+
+    Shard& GetShard(size_t hash) const;
+};
@@ -0,0 +1,24 @@
+#include "score_accumulator.h"
+
+//      (,  )   
+ScoreAccumulator::Lease ScoreAccumulator::Acquire(size_t slot_count, int first_slot) {
+    Lease accumulator = ScratchPool<ScoreAccumulator>::Acquire();
+    accumulator->Resize(slot_count);
+    accumulator->first_slot_ = first_slot;
+    return accumulator;
+}
+
+void ScoreAccumulator::Resize(size_t slot_count) {
+    if (scores_.size() < slot_count) {
+        scores_.resize(slot_count, 0.);
+        states_.resize(slot_count, SlotState::UNTOUCHED);
+    }
+}
+
+void ScoreAccumulator::Clear() {
+    for (const int slot : touched_) {
+        scores_[slot - first_slot_] = 0.;
+        states_[slot - first_slot_] = SlotState::UNTOUCHED;
+    }
+    touched_.clear();
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "scratch_pool.h"
+
+//  :         (),
+//              .
+//      ,    
+//    
+class ScoreAccumulator {
+public:
+    enum class SlotState : uint8_t {
+        UNTOUCHED,
+        ACCEPTED,
+        REJECTED,
+        EXCLUDED,
+    };
+
+    //,     ;       
+    using Lease = ScratchPool<ScoreAccumulator>::Lease;
+
+    //  [first_slot, first_slot + slot_count): ,    ,
+    //     
+    static Lease Acquire(size_t slot_count, int first_slot = 0);
+
+    //  -     
+    void Exclude(int slot) {
+        SlotState& state = states_[slot - first_slot_];
+        if (state == SlotState::UNTOUCHED) {
+            touched_.push_back(slot);
+        }
+        state = SlotState::EXCLUDED;
+    }
+
+    //       ( ),     
+    template <typename SlotFilter>
+    void Add(int slot, double value, SlotFilter&& filter) {
+        SlotState& state = states_[slot - first_slot_];
+        if (state == SlotState::UNTOUCHED) {
+            state = filter(slot) ? SlotState::ACCEPTED : SlotState::REJECTED;
+            touched_.push_back(slot);
+        }
+        if (state == SlotState::ACCEPTED) {
+            scores_[slot - first_slot_] += value;
+        }
+    }
+
+    bool IsExcluded(int slot) const {
+        return states_[slot - first_slot_] == SlotState::EXCLUDED;
+    }
+
+    //        
+    template <typename Function>
+    void ForEachAccepted(Function&& function) const {
+        ForEachAccepted(0, touched_.size(), function);
+    }
+
+    //       [first, last) -    
+    template <typename Function>
+    void ForEachAccepted(size_t first, size_t last, Function&& function) const {
+        for (size_t index = first; index < last; ++index) {
+            const int slot = touched_[index];
+            if (states_[slot - first_slot_] == SlotState::ACCEPTED) {
+                function(slot, scores_[slot - first_slot_]);
+            }
+        }
+    }
+
+    void Resize(size_t slot_count);
+
+    //   
+    void Clear();
+
+private:
+    std::vector<double> scores_;
+    std::vector<SlotState> states_;
+    std::vector<int> touched_;
+    int first_slot_ = 0;
+};
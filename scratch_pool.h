@@ -0,0 +1,55 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+//   :         ,
+//        .
+//      (   ,    )   .
+// T        Clear()
+template <typename T>
+class ScratchPool {
+public:
+    class Lease {
+    public:
+        explicit Lease(std::unique_ptr<T> object)
+            : object_(std::move(object))
+        {
+        }
+
+        Lease(Lease&& other) = default;
+
+        ~Lease() {
+            if (object_) {
+                object_->Clear();
+                GetPool().push_back(std::move(object_));
+            }
+        }
+
+        T& operator*() const {
+            return *object_;
+        }
+
+        T* operator->() const {
+            return object_.get();
+        }
+
+    private:
+        std::unique_ptr<T> object_;
+    };
+
+    static Lease Acquire() {
+        auto& pool = GetPool();
+        if (pool.empty()) {
+            return Lease(std::make_unique<T>());
+        }
+        Lease lease(std::move(pool.back()));
+        pool.pop_back();
+        return lease;
+    }
+
+private:
+    static std::vector<std::unique_ptr<T>>& GetPool() {
+        thread_local std::vector<std::unique_ptr<T>> pool;
+        return pool;
+    }
+};
@@ -2,6 +2,11 @@
 #include <cmath>
 #include <execution>
 #include <list>
+#include <cstring>
+#include <cstddef>
+#include <bit>
+#include <type_traits>
+#include <utility>
 
 #include "search_server.h"
 #include "log_duration.h"
@@ -28,23 +33,55 @@ void SearchServer::SetStopWords(const std::string& text) {
 
 void SearchServer::AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings) {
     //  id
-    if (document_id < 0 || documents_.count(document_id)) {
+    if (document_id < 0 || document_ordinals_.Find(document_id) != OrdinalMap::NO_ORDINAL) {
         throw std::invalid_argument("incorrect id");
     }
     const std::vector<std::string_view> words = SplitIntoWordsNoStop(document);
-    //    TF  
-    const double inv_word_count = 1.0 / words.size();
+    //    ,       
+    std::vector<TermDictionary::TermId> term_ids;
+    term_ids.reserve(words.size());
     for (const std::string_view word : words) {
-        document_to_words_freqs_[document_id][std::string(word)] += inv_word_count;
-        word_to_document_freqs_[(document_to_words_freqs_[document_id].find(word)->first)][document_id] += inv_word_count;
+        term_ids.push_back(term_dictionary_.Intern(word));
     }
-    documents_.emplace(document_id,
-        DocumentData{
-            ComputeAverageRating(ratings),
-            status
-        });
-    //    id  index_to_id   
-    ids_.push_back(document_id);
+    std::sort(term_ids.begin(), term_ids.end());
+    term_statistics_.resize(term_dictionary_.GetTermCount());
+    //    TF  ,          
+    //       
+    const int ordinal = static_cast<int>(document_ids_.size());
+    const double inv_word_count = 1.0 / words.size();
+    std::vector<DocumentTerm> document_terms;
+    Segment& segment = segments_.back();
+    segment.postings.resize(term_statistics_.size());
+    for (auto it = term_ids.begin(); it != term_ids.end();) {
+        const auto run_end = std::upper_bound(it, term_ids.end(), *it);
+        const double term_freq = (run_end - it) * inv_word_count;
+        document_terms.push_back({ *it, term_freq });
+        segment.postings.Mutable(*it).Append(ordinal, static_cast<uint32_t>(run_end - it), static_cast<uint32_t>(words.size()));
+        TermStatistics& statistics = term_statistics_.Mutable(*it);
+        ++statistics.document_count;
+        statistics.RaiseMaxTermFreq(term_freq);
+        it = run_end;
+    }
+    segment.ordinal_end = ordinal + 1;
+    document_ordinals_.Insert(document_id, ordinal);
+    document_ids_.push_back(document_id);
+    document_statuses_.push_back(status);
+    document_ratings_.push_back(ComputeAverageRating(ratings));
+    document_to_words_freqs_.push_back(CopyOnWriteArray<DocumentTerm>(std::move(document_terms)));
+    corpus_generation_ = NextCorpusGeneration();
+    SealFullSegment();
+}
+
+void SearchServer::AddDocuments(const std::vector<DocumentToAdd>& documents) {
+    AddDocuments(std::execution::par, documents);
+}
+
+void SearchServer::AddDocuments(const std::execution::sequenced_policy&, const std::vector<DocumentToAdd>& documents) {
+    AddDocumentsBatch(documents, nullptr);
+}
+
+void SearchServer::AddDocuments(const std::execution::parallel_policy&, const std::vector<DocumentToAdd>& documents) {
+    AddDocumentsBatch(documents, &GetThreadPool());
 }
 
 //FindTopDocuments   ,     ACTUAL  
@@ -57,8 +94,12 @@ std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_
     return FindTopDocuments(std::execution::seq, raw_query, required_status);
 }
 
+std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query, DocumentStatus required_status, size_t offset, size_t count) const {
+    return FindTopDocumentsByStatus(std::execution::seq, raw_query, required_status, offset, count);
+}
+
 size_t SearchServer::GetDocumentCount() const {
-    return documents_.size();
+    return document_ordinals_.size();
 }
 
 //   ,         -
@@ -67,31 +108,62 @@ std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDoc
 }
 
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::execution::sequenced_policy&, const std::string_view raw_query, int document_id) const {
-    Query query = ParseQuery(raw_query);
-    return MatchDocument(query, document_id);
+    const QueryLease query = ParseQuery(raw_query);
+    return MatchDocument(*query, document_id);
 }
 
 std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::execution::parallel_policy&, const std::string_view raw_query, int document_id) const {
-    Query_vector query = ParseQuery_Vector(raw_query);
-    return MatchDocument(std::execution::par, query, document_id);
+    const QueryLease query = ParseQuery(raw_query);
+    return MatchDocument(std::execution::par, *query, document_id);
 }
 
 std::vector<std::tuple<int, std::vector<std::string_view>, DocumentStatus>> SearchServer::MatchDocuments(const std::string_view raw_query) const {
-    Query query = ParseQuery(raw_query);
+    const QueryLease query = ParseQuery(raw_query);
+    std::vector<std::vector<std::string_view>> matched_words(document_ids_.size());
+    ForEachMatchedChunk(std::execution::par, *query, [&](const MatchedChunk& chunk) {
+        for (size_t index = 0; index < chunk.ordinals.size(); ++index) {
+            matched_words[chunk.ordinals[index]].assign(chunk.words.begin() + chunk.word_offsets[index], chunk.words.begin() + chunk.word_offsets[index + 1]);
+        }
+        });
+    // id  ,     id
+    std::vector<std::pair<int, int>> id_ordinals;
+    id_ordinals.reserve(document_ordinals_.size());
+    document_ordinals_.ForEach([&](int id, int ordinal) {
+        id_ordinals.emplace_back(id, ordinal);
+        });
+    std::sort(id_ordinals.begin(), id_ordinals.end());
     std::vector<std::tuple<int, std::vector<std::string_view>, DocumentStatus>> result;
-    for (auto const& [id, data] : documents_) {
-        auto [words, status] = MatchDocument(query, id);
-        result.push_back({ id , words, status });
+    result.reserve(id_ordinals.size());
+    for (const auto& [id, ordinal] : id_ordinals) {
+        result.push_back({ id, std::move(matched_words[ordinal]), document_statuses_[ordinal] });
     }
     return result;
 }
 
-const std::map<std::string, double, std::less<>>& SearchServer::GetWordFrequencies(int document_id) const {
-    if (!documents_.count(document_id)) {
-        static std::map<std::string, double, std::less<>> empty;
-        return empty;
+std::map<std::string_view, double> SearchServer::GetWordFrequencies(int document_id) const {
+    std::map<std::string_view, double> word_freqs;
+    const int ordinal = document_ordinals_.Find(document_id);
+    if (ordinal == OrdinalMap::NO_ORDINAL) {
+        return word_freqs;
+    }
+    for (const auto [term_id, term_freq] : document_to_words_freqs_[ordinal]) {
+        word_freqs.emplace(term_dictionary_.GetTerm(term_id), term_freq);
+    }
+    return word_freqs;
+}
+
+std::vector<TermDictionary::TermId> SearchServer::GetDocumentTermIds(int document_id) const {
+    std::vector<TermDictionary::TermId> term_ids;
+    const int ordinal = document_ordinals_.Find(document_id);
+    if (ordinal == OrdinalMap::NO_ORDINAL) {
+        return term_ids;
     }
-    return document_to_words_freqs_.at(document_id);
+    const auto& document_terms = document_to_words_freqs_[ordinal];
+    term_ids.reserve(document_terms.size());
+    for (const auto [term_id, _] : document_terms) {
+        term_ids.push_back(term_id);
+    }
+    return term_ids;
 }
 
 //int SearchServer::GetDocumentId(int index) const {
@@ -101,12 +173,26 @@ const std::map<std::string, double, std::less<>>& SearchServer::GetWordFrequenci
 //    throw std::out_of_range("There are no documents with this index");
 //}
 
-std::vector<int>::iterator SearchServer::begin() {
-    return ids_.begin();
+SearchServer::DocumentIdIterator SearchServer::begin() const {
+    return DocumentIdIterator(this, 0);
+}
+
+SearchServer::DocumentIdIterator SearchServer::end() const {
+    return DocumentIdIterator(this, static_cast<int>(document_ids_.size()));
 }
 
-std::vector<int>::iterator SearchServer::end() {
-    return ids_.end();
+//   ,     O(  +  )
+void SearchServer::DocumentIdIterator::SkipRemoved() {
+    const std::vector<Segment>& segments = server_->segments_;
+    const int ordinal_end = static_cast<int>(server_->document_ids_.size());
+    for (; ordinal_ < ordinal_end; ++ordinal_) {
+        while (segments[segment_index_].ordinal_end <= ordinal_) {
+            ++segment_index_;
+        }
+        if (!segments[segment_index_].IsRemoved(ordinal_)) {
+            return;
+        }
+    }
 }
 
 void SearchServer::RemoveDocument(int document_id) {
@@ -114,74 +200,692 @@ void SearchServer::RemoveDocument(int document_id) {
 }
 
 void SearchServer::RemoveDocument(const std::execution::sequenced_policy&, int document_id) {
-    if (!documents_.count(document_id))
-        return;
+    if (MarkDocumentRemoved(document_id)) {
+        corpus_generation_ = NextCorpusGeneration();
+        CompactIfNeeded();
+    }
+}
 
-    std::map<std::string, double, std::less<>> words;
-    {
-        auto it = document_to_words_freqs_.find(document_id);
-        if (it != document_to_words_freqs_.end()) {
-            words = document_to_words_freqs_.at(document_id);
-            document_to_words_freqs_.erase(it);
+//    -,       
+void SearchServer::RemoveDocument(const std::execution::parallel_policy&, int document_id) {
+    RemoveDocument(std::execution::seq, document_id);
+}
+
+void SearchServer::RemoveDocuments(const std::vector<int>& document_ids) {
+    bool is_removed = false;
+    for (const int document_id : document_ids) {
+        is_removed = MarkDocumentRemoved(document_id) || is_removed;
+    }
+    if (is_removed) {
+        corpus_generation_ = NextCorpusGeneration();
+        CompactIfNeeded();
+    }
+}
+
+void SearchServer::SetThreadPool(std::shared_ptr<ThreadPool> thread_pool) {
+    thread_pool_ = std::move(thread_pool);
+}
+
+ThreadPool& SearchServer::GetThreadPool() const {
+    return thread_pool_ ? *thread_pool_ : ThreadPool::GetDefault();
+}
+
+void SearchServer::SetParallelSearchMode(ParallelSearchMode mode) {
+    parallel_search_mode_ = mode;
+}
+
+void SearchServer::SetScoringMode(ScoringMode mode) {
+    scoring_mode_ = mode;
+}
+
+uint64_t SearchServer::GetVisitedPostingCount() {
+    return visited_posting_count_;
+}
+
+void SearchServer::SetResultCache(std::shared_ptr<ResultCache> result_cache) {
+    result_cache_ = std::move(result_cache);
+}
+
+const std::shared_ptr<ResultCache>& SearchServer::GetResultCache() const {
+    return result_cache_;
+}
+
+void SearchServer::SetSegmentCapacity(size_t document_count) {
+    segment_capacity_ = std::max<size_t>(1u, document_count);
+    SealFullSegment();
+}
+
+size_t SearchServer::GetSegmentCount() const {
+    return segments_.size();
+}
+
+void SearchServer::SetAutoMergeSegments(bool auto_merge) {
+    auto_merge_segments_ = auto_merge;
+}
+
+bool SearchServer::IsSegmentMergeNeeded() const {
+    return PlanSegmentMerge().has_value();
+}
+
+void SearchServer::MergeSegments() {
+    while (std::optional<SegmentMerge> merge = PrepareSegmentMerge()) {
+        ApplySegmentMerge(std::move(*merge));
+    }
+}
+
+//   :          .
+//     ,     
+std::optional<SearchServer::SegmentMerge> SearchServer::PrepareSegmentMerge() const {
+    const std::optional<std::pair<size_t, size_t>> plan = PlanSegmentMerge();
+    if (!plan) {
+        return std::nullopt;
+    }
+    return BuildSegmentMerge(plan->first, plan->second);
+}
+
+SearchServer::SegmentMerge SearchServer::BuildSegmentMerge(size_t first, size_t last) const {
+    SegmentMerge merge;
+    Segment& merged = merge.segment;
+    merged.ordinal_begin = segments_[first].ordinal_begin;
+    merged.ordinal_end = segments_[last - 1].ordinal_end;
+    size_t term_count = 0;
+    for (size_t index = first; index < last; ++index) {
+        merge.source_bounds.push_back(segments_[index].ordinal_begin);
+        term_count = std::max(term_count, segments_[index].postings.size());
+    }
+    merge.source_bounds.push_back(merged.ordinal_end);
+
+    std::vector<uint64_t> tombstones((merged.ordinal_end - merged.ordinal_begin + 63) / 64);
+    for (size_t index = first; index < last; ++index) {
+        const Segment& segment = segments_[index];
+        for (int ordinal = segment.ordinal_begin; ordinal < segment.ordinal_end; ++ordinal) {
+            if (segment.IsRemoved(ordinal)) {
+                const size_t bit = static_cast<size_t>(ordinal - merged.ordinal_begin);
+                tombstones[bit / 64] |= uint64_t{ 1 } << (bit % 64);
+                ++merged.tombstone_count;
+            }
         }
     }
-    {
-        for (const auto [word, freq] : words) {
-            if (word_to_document_freqs_.count(word) != 0) {
-                auto it = word_to_document_freqs_.at(word).find(document_id);
-                if (it != word_to_document_freqs_.at(word).end()) {
-                    word_to_document_freqs_.at(word).erase(document_id);
+    merged.purged_count = merged.tombstone_count;
+    merged.tombstones = PersistentArray<uint64_t>(std::move(tombstones));
+
+    std::vector<PostingList> postings(term_count);
+    ThreadPool& thread_pool = GetThreadPool();
+    const size_t part_count = std::max<size_t>(1u, thread_pool.GetThreadCount() * 4);
+    const size_t part_size = term_count / part_count + 1;
+    thread_pool.ParallelFor(part_count, [&](size_t part) {
+        for (size_t term_id = part * part_size; term_id < std::min(term_count, (part + 1) * part_size); ++term_id) {
+            PostingList& live_postings = postings[term_id];
+            for (size_t index = first; index < last; ++index) {
+                const Segment& segment = segments_[index];
+                if (const PostingList* segment_postings = segment.FindPostingList(static_cast<TermDictionary::TermId>(term_id))) {
+                    segment_postings->ForEachRaw([&](int ordinal, uint32_t count, uint32_t word_count) {
+                        if (!segment.IsRemoved(ordinal)) {
+                            live_postings.Append(ordinal, count, word_count);
+                        }
+                        });
                 }
             }
+            live_postings.ShrinkToFit();
         }
+        });
+    merged.postings = PersistentArray<PostingList>(std::move(postings));
+    return merge;
+}
+
+bool SearchServer::ApplySegmentMerge(SegmentMerge merge) {
+    const size_t source_count = merge.source_bounds.size() - 1;
+    const auto first_it = std::find_if(segments_.begin(), segments_.end() - 1, [&](const Segment& segment) {
+        return segment.ordinal_begin == merge.source_bounds.front();
+        });
+    const size_t first = first_it - segments_.begin();
+    if (first + source_count >= segments_.size()) {
+        return false;
     }
-    {
-        auto it = documents_.find(document_id);
-        if (it != documents_.end()) {
-            documents_.erase(it);
+    for (size_t index = 0; index < source_count; ++index) {
+        const Segment& segment = segments_[first + index];
+        if (segment.ordinal_begin != merge.source_bounds[index] || segment.ordinal_end != merge.source_bounds[index + 1]) {
+            return false;
         }
     }
-    {
-        auto it = remove(ids_.begin(), ids_.end(), document_id);
-        ids_.erase(it, ids_.end());
+    //,    ,      
+    Segment& merged = merge.segment;
+    for (size_t index = first; index < first + source_count; ++index) {
+        const Segment& segment = segments_[index];
+        if (segment.tombstone_count == 0) {
+            continue;
+        }
+        for (int ordinal = segment.ordinal_begin; ordinal < segment.ordinal_end; ++ordinal) {
+            if (segment.IsRemoved(ordinal) && !merged.IsRemoved(ordinal)) {
+                merged.MarkRemoved(ordinal);
+            }
+        }
     }
+    segments_[first] = std::move(merged);
+    segments_.erase(segments_.begin() + first + 1, segments_.begin() + first + source_count);
+    return true;
 }
 
-void SearchServer::RemoveDocument(const std::execution::parallel_policy&, int document_id) {
-    if (!documents_.count(document_id))
-        return;
+void SearchServer::SetCompactionThreshold(double ratio) {
+    compaction_threshold_ = ratio;
+    CompactIfNeeded();
+}
 
-    std::map<std::string, double, std::less<>> const& words = document_to_words_freqs_.at(document_id);
-    std::for_each(
-        std::execution::par,
-        words.begin(), words.end(),
-        [&](auto const& word) {
-            word_to_document_freqs_.at(word.first).erase(document_id);
+void SearchServer::Compact() {
+    const Segment& active_segment = segments_.back();
+    if (active_segment.ordinal_end > active_segment.ordinal_begin) {
+        const int ordinal_end = active_segment.ordinal_end;
+        Segment& next_segment = segments_.emplace_back();
+        next_segment.ordinal_begin = ordinal_end;
+        next_segment.ordinal_end = ordinal_end;
+    }
+    for (size_t index = 0; index + 1 < segments_.size(); ++index) {
+        if (segments_[index].GetPendingRemovalCount() > 0) {
+            ApplySegmentMerge(BuildSegmentMerge(index, index + 1));
         }
-    );
+    }
+    if (auto_merge_segments_) {
+        MergeSegments();
+    }
+}
+
+size_t SearchServer::GetPendingRemovalCount() const {
+    size_t pending_count = 0;
+    for (const Segment& segment : segments_) {
+        pending_count += segment.GetPendingRemovalCount();
+    }
+    return pending_count;
+}
+
+size_t SearchServer::GetPostingMemoryUsage() const {
+    size_t memory_usage = 0;
+    for (const Segment& segment : segments_) {
+        memory_usage += segment.postings.size() * sizeof(PostingList);
+        segment.postings.ForEach([&](const PostingList& postings) {
+            memory_usage += postings.GetDataSize();
+            });
+    }
+    return memory_usage;
+}
+
+namespace {
+
+//         ,       
+template <typename Record, typename FieldWriter>
+void AppendRecords(SnapshotWriter& writer, std::vector<char>& buffer, size_t count, FieldWriter write_fields) {
+    buffer.assign(count * sizeof(Record), 0);
+    for (size_t index = 0; index < count; ++index) {
+        write_fields(buffer.data() + index * sizeof(Record), index);
+    }
+    writer.Append(buffer.data(), buffer.size());
+}
 
-    document_to_words_freqs_.erase(document_id);
-    documents_.erase(document_id);
-    ids_.erase(remove(ids_.begin(), ids_.end(), document_id), ids_.end());
+template <typename Field>
+void WriteField(char* record, size_t offset, Field value) {
+    std::memcpy(record + offset, &value, sizeof(value));
+}
+
+//       ,   
+void CheckOffsets(std::span<const uint64_t> offsets, size_t expected_count, size_t total_size) {
+    if (offsets.size() != expected_count + 1 || offsets.front() != 0 || offsets.back() != total_size
+        || !std::is_sorted(offsets.begin(), offsets.end())) {
+        throw std::runtime_error("Snapshot offsets are corrupted");
+    }
+}
+
+} // namespace
+
+void SearchServer::SaveSnapshot(const std::string& path) const {
+    static_assert(std::is_standard_layout_v<PostingList::Block> && sizeof(PostingList::Block) == 2 * sizeof(int32_t));
+    static_assert(std::is_standard_layout_v<DocumentTerm>);
+
+    SnapshotWriter writer(path);
+    std::vector<char> buffer;
+    std::vector<uint64_t> offsets;
+    const auto write_strings = [&](SnapshotSection strings_section, SnapshotSection offsets_section, const auto& strings) {
+        offsets.assign(1, 0);
+        writer.BeginSection(strings_section);
+        for (const std::string_view text : strings) {
+            writer.Append(text.data(), text.size());
+            offsets.push_back(offsets.back() + text.size());
+        }
+        writer.EndSection();
+        writer.AddSection(offsets_section, offsets);
+    };
+
+    write_strings(SnapshotSection::STOP_WORD_STRINGS, SnapshotSection::STOP_WORD_OFFSETS, stop_words_);
+    std::vector<std::string_view> terms;
+    terms.reserve(term_dictionary_.GetTermCount());
+    for (TermDictionary::TermId term_id = 0; term_id < term_dictionary_.GetTermCount(); ++term_id) {
+        terms.push_back(term_dictionary_.GetTerm(term_id));
+    }
+    write_strings(SnapshotSection::TERM_STRINGS, SnapshotSection::TERM_OFFSETS, terms);
+    writer.AddSection(SnapshotSection::TERM_HASH_SLOTS, term_dictionary_.BuildHashSlots());
+
+    //        ,    
+    std::vector<int> snapshot_ordinals(document_ids_.size(), -1);
+    std::vector<int> live_ordinals;
+    live_ordinals.reserve(document_ordinals_.size());
+    document_ordinals_.ForEach([&](int, int ordinal) {
+        live_ordinals.push_back(ordinal);
+        });
+    std::sort(live_ordinals.begin(), live_ordinals.end());
+    for (size_t index = 0; index < live_ordinals.size(); ++index) {
+        snapshot_ordinals[live_ordinals[index]] = static_cast<int>(index);
+    }
+
+    //            ,
+    //   .          ,
+    //       
+    std::vector<PostingList> live_postings(term_dictionary_.GetTermCount());
+    for (TermDictionary::TermId term_id = 0; term_id < term_dictionary_.GetTermCount(); ++term_id) {
+        for (const Segment& segment : segments_) {
+            if (const PostingList* postings = segment.FindPostingList(term_id)) {
+                postings->ForEachRaw([&](int ordinal, uint32_t count, uint32_t word_count) {
+                    if (snapshot_ordinals[ordinal] >= 0) {
+                        live_postings[term_id].Append(snapshot_ordinals[ordinal], count, word_count);
+                    }
+                    });
+            }
+        }
+    }
+    offsets.assign(1, 0);
+    for (const PostingList& postings : live_postings) {
+        offsets.push_back(offsets.back() + postings.size());
+    }
+    writer.AddSection(SnapshotSection::POSTING_OFFSETS, offsets);
+    writer.BeginSection(SnapshotSection::POSTING_BLOCKS);
+    for (const PostingList& postings : live_postings) {
+        writer.Append(postings.GetBlocks().begin(), postings.GetBlocks().size() * sizeof(PostingList::Block));
+    }
+    writer.EndSection();
+    offsets.assign(1, 0);
+    for (const PostingList& postings : live_postings) {
+        offsets.push_back(offsets.back() + postings.GetData().size());
+    }
+    writer.AddSection(SnapshotSection::POSTING_DATA_OFFSETS, offsets);
+    writer.BeginSection(SnapshotSection::POSTING_DATA);
+    for (const PostingList& postings : live_postings) {
+        writer.Append(postings.GetData().begin(), postings.GetData().size());
+    }
+    writer.EndSection();
+
+    offsets.assign(1, 0);
+    for (const int ordinal : live_ordinals) {
+        offsets.push_back(offsets.back() + document_to_words_freqs_[ordinal].size());
+    }
+    writer.AddSection(SnapshotSection::DOCUMENT_TERM_OFFSETS, offsets);
+    writer.BeginSection(SnapshotSection::DOCUMENT_TERMS);
+    for (const int ordinal : live_ordinals) {
+        const auto& document_terms = document_to_words_freqs_[ordinal];
+        AppendRecords<DocumentTerm>(writer, buffer, document_terms.size(), [&](char* record, size_t index) {
+            WriteField(record, offsetof(DocumentTerm, term_id), document_terms[index].term_id);
+            WriteField(record, offsetof(DocumentTerm, term_freq), document_terms[index].term_freq);
+            });
+    }
+    writer.EndSection();
+
+    std::vector<int32_t> ids;
+    std::vector<int32_t> statuses;
+    std::vector<int32_t> ratings;
+    for (const int ordinal : live_ordinals) {
+        ids.push_back(document_ids_[ordinal]);
+        statuses.push_back(static_cast<int32_t>(document_statuses_[ordinal]));
+        ratings.push_back(document_ratings_[ordinal]);
+    }
+    writer.AddSection(SnapshotSection::DOCUMENT_IDS, ids);
+    writer.AddSection(SnapshotSection::DOCUMENT_STATUSES, statuses);
+    writer.AddSection(SnapshotSection::DOCUMENT_RATINGS, ratings);
+    writer.Finish();
+}
+
+//    ,     ;
+//       
+SearchServer SearchServer::LoadSnapshot(const std::string& path, SnapshotVerification verification) {
+    auto file = std::make_shared<const MappedFile>(path);
+    const SnapshotReader reader(*file, verification);
+    SearchServer server;
+    server.snapshot_file_ = file;
+
+    const std::string_view stop_word_strings = reader.GetBytes(SnapshotSection::STOP_WORD_STRINGS);
+    const auto stop_word_offsets = reader.GetArray<uint64_t>(SnapshotSection::STOP_WORD_OFFSETS);
+    if (stop_word_offsets.empty()) {
+        throw std::runtime_error("Snapshot offsets are corrupted");
+    }
+    CheckOffsets(stop_word_offsets, stop_word_offsets.size() - 1, stop_word_strings.size());
+    for (size_t index = 0; index + 1 < stop_word_offsets.size(); ++index) {
+        server.stop_words_.emplace(stop_word_strings.substr(stop_word_offsets[index], stop_word_offsets[index + 1] - stop_word_offsets[index]));
+    }
+
+    const std::string_view term_strings = reader.GetBytes(SnapshotSection::TERM_STRINGS);
+    const auto term_offsets = reader.GetArray<uint64_t>(SnapshotSection::TERM_OFFSETS);
+    const auto term_slots = reader.GetArray<TermDictionary::TermId>(SnapshotSection::TERM_HASH_SLOTS);
+    if (term_offsets.empty()) {
+        throw std::runtime_error("Snapshot offsets are corrupted");
+    }
+    const size_t term_count = term_offsets.size() - 1;
+    CheckOffsets(term_offsets, term_count, term_strings.size());
+    if (term_slots.size() <= term_count || (term_slots.size() & (term_slots.size() - 1)) != 0
+        || std::any_of(term_slots.begin(), term_slots.end(), [term_count](TermDictionary::TermId term_id) {
+            return term_id != TermDictionary::NO_TERM && term_id >= term_count;
+            })) {
+        throw std::runtime_error("Snapshot term table is corrupted");
+    }
+    server.term_dictionary_ = TermDictionary({ term_strings.data(), term_offsets.data(), term_slots.data(), term_count, term_slots.size() });
+
+    const auto ids = reader.GetArray<int32_t>(SnapshotSection::DOCUMENT_IDS);
+    const auto statuses = reader.GetArray<int32_t>(SnapshotSection::DOCUMENT_STATUSES);
+    const auto ratings = reader.GetArray<int32_t>(SnapshotSection::DOCUMENT_RATINGS);
+    const auto document_term_offsets = reader.GetArray<uint64_t>(SnapshotSection::DOCUMENT_TERM_OFFSETS);
+    const auto document_terms = reader.GetArray<DocumentTerm>(SnapshotSection::DOCUMENT_TERMS);
+    const size_t document_count = ids.size();
+    CheckOffsets(document_term_offsets, document_count, document_terms.size());
+    if (statuses.size() != document_count || ratings.size() != document_count || document_count > static_cast<size_t>(std::numeric_limits<int>::max())) {
+        throw std::runtime_error("Snapshot documents are corrupted");
+    }
+
+    //       , . PostingList::IsValid.
+    //     
+    const auto posting_offsets = reader.GetArray<uint64_t>(SnapshotSection::POSTING_OFFSETS);
+    const auto posting_blocks = reader.GetArray<PostingList::Block>(SnapshotSection::POSTING_BLOCKS);
+    const auto posting_data_offsets = reader.GetArray<uint64_t>(SnapshotSection::POSTING_DATA_OFFSETS);
+    const auto posting_data = reader.GetArray<uint8_t>(SnapshotSection::POSTING_DATA);
+    CheckOffsets(posting_offsets, term_count, posting_offsets.empty() ? 0 : posting_offsets.back());
+    CheckOffsets(posting_data_offsets, term_count, posting_data.size());
+    std::vector<PostingList> segment_postings(term_count);
+    std::vector<TermStatistics> term_statistics(term_count);
+    size_t block_offset = 0;
+    for (size_t term_id = 0; term_id < term_count; ++term_id) {
+        const size_t posting_count = posting_offsets[term_id + 1] - posting_offsets[term_id];
+        const size_t block_count = (posting_count + PostingList::BLOCK_SIZE - 1) / PostingList::BLOCK_SIZE;
+        const size_t data_size = posting_data_offsets[term_id + 1] - posting_data_offsets[term_id];
+        if (block_count > posting_blocks.size() - block_offset) {
+            throw std::runtime_error("Snapshot posting lists are corrupted");
+        }
+        segment_postings[term_id] = PostingList::View(posting_blocks.data() + block_offset,
+            posting_data.data() + posting_data_offsets[term_id], data_size, posting_count);
+        if (!segment_postings[term_id].IsValid(static_cast<int>(document_count))) {
+            throw std::runtime_error("Snapshot posting lists are corrupted");
+        }
+        term_statistics[term_id].document_count = static_cast<int>(posting_count);
+        block_offset += block_count;
+    }
+    if (block_offset != posting_blocks.size()) {
+        throw std::runtime_error("Snapshot posting lists are corrupted");
+    }
+
+    server.term_statistics_ = PersistentArray<TermStatistics>(std::move(term_statistics));
+    server.document_ids_ = PersistentArray<int>(std::vector<int>(ids.begin(), ids.end()));
+    server.document_ratings_ = PersistentArray<int>(std::vector<int>(ratings.begin(), ratings.end()));
+    std::vector<DocumentStatus> document_statuses;
+    document_statuses.reserve(document_count);
+    std::vector<CopyOnWriteArray<DocumentTerm>> document_to_words_freqs;
+    document_to_words_freqs.reserve(document_count);
+    std::vector<std::pair<int, int>> id_ordinals;
+    id_ordinals.reserve(document_count);
+    for (size_t ordinal = 0; ordinal < document_count; ++ordinal) {
+        if (statuses[ordinal] < 0 || statuses[ordinal] > static_cast<int32_t>(DocumentStatus::REMOVED)) {
+            throw std::runtime_error("Snapshot documents are corrupted");
+        }
+        if (ids[ordinal] < 0) {
+            throw std::runtime_error("Snapshot documents are corrupted");
+        }
+        id_ordinals.emplace_back(ids[ordinal], static_cast<int>(ordinal));
+        document_statuses.push_back(static_cast<DocumentStatus>(statuses[ordinal]));
+        //         STRUCTURE,     
+        //     ,      
+        const DocumentTerm* terms_begin = document_terms.data() + document_term_offsets[ordinal];
+        const DocumentTerm* terms_end = document_terms.data() + document_term_offsets[ordinal + 1];
+        for (const DocumentTerm* term = terms_begin; term != terms_end; ++term) {
+            if (term->term_id >= term_count || (term != terms_begin && term->term_id <= term[-1].term_id)) {
+                throw std::runtime_error("Snapshot documents are corrupted");
+            }
+        }
+        document_to_words_freqs.push_back(CopyOnWriteArray<DocumentTerm>::View(terms_begin, static_cast<size_t>(terms_end - terms_begin)));
+    }
+    if (!server.document_ordinals_.Assign(std::move(id_ordinals))) {
+        throw std::runtime_error("Snapshot documents are corrupted");
+    }
+    server.document_statuses_ = PersistentArray<DocumentStatus>(std::move(document_statuses));
+    server.document_to_words_freqs_ = PersistentArray<CopyOnWriteArray<DocumentTerm>>(std::move(document_to_words_freqs));
+    //     ,     
+    if (document_count > 0) {
+        const int ordinal_end = static_cast<int>(document_count);
+        Segment& segment = server.segments_.front();
+        segment.ordinal_end = ordinal_end;
+        segment.postings = PersistentArray<PostingList>(std::move(segment_postings));
+        server.segments_.emplace_back().ordinal_begin = ordinal_end;
+        server.segments_.back().ordinal_end = ordinal_end;
+    }
+    return server;
 }
 
 //--private functions:
 
+thread_local uint64_t SearchServer::visited_posting_count_ = 0;
+
+uint64_t SearchServer::NextCorpusGeneration() {
+    static std::atomic<uint64_t> next_generation{ 1 };
+    return next_generation.fetch_add(1, std::memory_order_relaxed);
+}
+
 bool SearchServer::IsStopWord(const std::string_view word) const {
     return stop_words_.count(word) > 0;
 }
 
 std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(const std::string_view text) const {
     std::vector<std::string_view> words;
-    for (const std::string_view word : SplitIntoWords(text)) {
-        if (!IsValidWord(word)) {
-            throw std::invalid_argument("document contains special characters");
+    if (!SplitIntoValidWords(text, words)) {
+        throw std::invalid_argument("document contains special characters");
+    }
+    words.erase(std::remove_if(words.begin(), words.end(), [this](const std::string_view word) { return IsStopWord(word); }), words.end());
+    return words;
+}
+
+//     ,      
+void SearchServer::AddDocumentsBatch(const std::vector<DocumentToAdd>& documents, ThreadPool* thread_pool) {
+    const size_t part_count = thread_pool == nullptr ? 1 : std::max<size_t>(1u, thread_pool->GetThreadCount() * 4);
+    const auto for_each_part = [thread_pool](size_t count, const auto& function) {
+        if (thread_pool != nullptr) {
+            thread_pool->ParallelFor(count, function);
         }
-        if (!IsStopWord(word)) {
-            words.push_back(word);
+        else {
+            for (size_t index = 0; index < count; ++index) {
+                function(index);
+            }
+        }
+    };
+
+    // id: ,      
+    {
+        std::vector<int> batch_ids;
+        batch_ids.reserve(documents.size());
+        for (const DocumentToAdd& document : documents) {
+            if (document.id < 0 || document_ordinals_.Find(document.id) != OrdinalMap::NO_ORDINAL) {
+                throw std::invalid_argument("incorrect id");
+            }
+            batch_ids.push_back(document.id);
+        }
+        std::sort(batch_ids.begin(), batch_ids.end());
+        if (std::adjacent_find(batch_ids.begin(), batch_ids.end()) != batch_ids.end()) {
+            throw std::invalid_argument("incorrect id");
         }
     }
-    return words;
+
+    //  :           
+    const size_t document_part_size = documents.size() / part_count + 1;
+    std::vector<TermDictionary> part_dictionaries(part_count);
+    std::vector<std::vector<TermDictionary::TermId>> document_term_ids(documents.size());
+    for_each_part(part_count, [&](size_t part) {
+        const size_t part_end = std::min(documents.size(), (part + 1) * document_part_size);
+        for (size_t index = part * document_part_size; index < part_end; ++index) {
+            const std::vector<std::string_view> words = SplitIntoWordsNoStop(documents[index].text);
+            auto& term_ids = document_term_ids[index];
+            term_ids.reserve(words.size());
+            for (const std::string_view word : words) {
+                term_ids.push_back(part_dictionaries[part].Intern(word));
+            }
+        }
+        });
+
+    //    : ,       ,     
+    std::vector<std::vector<TermDictionary::TermId>> part_term_ids(part_count);
+    for (size_t part = 0; part < part_count; ++part) {
+        const TermDictionary& part_dictionary = part_dictionaries[part];
+        part_term_ids[part].reserve(part_dictionary.GetTermCount());
+        for (TermDictionary::TermId term_id = 0; term_id < part_dictionary.GetTermCount(); ++term_id) {
+            part_term_ids[part].push_back(term_dictionary_.Intern(part_dictionary.GetTerm(term_id)));
+        }
+    }
+
+    //      TF,   AddDocument;      
+    //   
+    std::vector<std::vector<DocumentTerm>> document_terms(documents.size());
+    std::vector<std::vector<uint32_t>> document_term_counts(documents.size());
+    std::vector<uint32_t> word_counts(documents.size());
+    for_each_part(part_count, [&](size_t part) {
+        const size_t part_end = std::min(documents.size(), (part + 1) * document_part_size);
+        for (size_t index = part * document_part_size; index < part_end; ++index) {
+            auto& term_ids = document_term_ids[index];
+            for (TermDictionary::TermId& term_id : term_ids) {
+                term_id = part_term_ids[part][term_id];
+            }
+            std::sort(term_ids.begin(), term_ids.end());
+            const double inv_word_count = 1.0 / term_ids.size();
+            word_counts[index] = static_cast<uint32_t>(term_ids.size());
+            for (auto it = term_ids.begin(); it != term_ids.end();) {
+                const auto run_end = std::upper_bound(it, term_ids.end(), *it);
+                document_terms[index].push_back({ *it, (run_end - it) * inv_word_count });
+                document_term_counts[index].push_back(static_cast<uint32_t>(run_end - it));
+                it = run_end;
+            }
+            term_ids = {};
+        }
+        });
+
+    //   :          
+    //        .      
+    //     ,      
+    const int first_ordinal = static_cast<int>(document_ids_.size());
+    term_statistics_.resize(term_dictionary_.GetTermCount());
+    Segment& segment = segments_.back();
+    segment.postings.resize(term_statistics_.size());
+    //      :     ,    
+    // ,  ,    ,        .
+    //         
+    std::vector<TermDictionary::TermId> touched_term_ids;
+    std::vector<int> touched_counts;
+    std::vector<uint32_t> touched_indices;
+    size_t batch_posting_count = 0;
+    for (const std::vector<DocumentTerm>& terms : document_terms) {
+        batch_posting_count += terms.size();
+    }
+    if (batch_posting_count >= term_statistics_.size()) {
+        touched_indices.assign(term_statistics_.size(), 0);
+        for (const std::vector<DocumentTerm>& terms : document_terms) {
+            for (const DocumentTerm& document_term : terms) {
+                ++touched_indices[document_term.term_id];
+            }
+        }
+        for (size_t term_id = 0; term_id < touched_indices.size(); ++term_id) {
+            if (touched_indices[term_id] != 0) {
+                touched_counts.push_back(static_cast<int>(touched_indices[term_id]));
+                touched_indices[term_id] = static_cast<uint32_t>(touched_term_ids.size());
+                touched_term_ids.push_back(static_cast<TermDictionary::TermId>(term_id));
+            }
+        }
+    }
+    else {
+        std::vector<TermDictionary::TermId> batch_term_ids;
+        batch_term_ids.reserve(batch_posting_count);
+        for (const std::vector<DocumentTerm>& terms : document_terms) {
+            for (const DocumentTerm& document_term : terms) {
+                batch_term_ids.push_back(document_term.term_id);
+            }
+        }
+        std::sort(batch_term_ids.begin(), batch_term_ids.end());
+        for (auto it = batch_term_ids.begin(); it != batch_term_ids.end();) {
+            const auto run_end = std::upper_bound(it, batch_term_ids.end(), *it);
+            touched_term_ids.push_back(*it);
+            touched_counts.push_back(static_cast<int>(run_end - it));
+            it = run_end;
+        }
+    }
+    const auto find_touched_index = [&](TermDictionary::TermId term_id) {
+        if (!touched_indices.empty()) {
+            return touched_indices[term_id];
+        }
+        return static_cast<uint32_t>(std::lower_bound(touched_term_ids.begin(), touched_term_ids.end(), term_id) - touched_term_ids.begin());
+    };
+    //          
+    std::vector<PostingList*> touched_postings;
+    std::vector<TermStatistics*> touched_statistics;
+    std::vector<uint32_t> touched_parts;
+    touched_postings.reserve(touched_term_ids.size());
+    touched_statistics.reserve(touched_term_ids.size());
+    touched_parts.reserve(touched_term_ids.size());
+    size_t posting_count_before = 0;
+    for (size_t index = 0; index < touched_term_ids.size(); ++index) {
+        touched_postings.push_back(&segment.postings.Mutable(touched_term_ids[index]));
+        touched_statistics.push_back(&term_statistics_.Mutable(touched_term_ids[index]));
+        touched_statistics.back()->document_count += touched_counts[index];
+        touched_parts.push_back(static_cast<uint32_t>(posting_count_before * part_count / batch_posting_count));
+        posting_count_before += static_cast<size_t>(touched_counts[index]);
+    }
+
+    //    [ ][ ]    , 
+    //       .      ,
+    //       
+    struct BatchPosting {
+        uint32_t touched_index = 0;
+        uint32_t document_index = 0;
+        uint32_t term_count = 0;
+    };
+    std::vector<std::vector<std::vector<BatchPosting>>> posting_buckets(part_count, std::vector<std::vector<BatchPosting>>(part_count));
+    for_each_part(part_count, [&](size_t part) {
+        std::vector<std::vector<BatchPosting>>& buckets = posting_buckets[part];
+        const size_t part_end = std::min(documents.size(), (part + 1) * document_part_size);
+        for (size_t index = part * document_part_size; index < part_end; ++index) {
+            const std::vector<DocumentTerm>& terms = document_terms[index];
+            for (size_t term_index = 0; term_index < terms.size(); ++term_index) {
+                const uint32_t touched_index = find_touched_index(terms[term_index].term_id);
+                buckets[touched_parts[touched_index]].push_back({ touched_index, static_cast<uint32_t>(index), document_term_counts[index][term_index] });
+            }
+            document_term_counts[index] = {};
+        }
+        });
+    for_each_part(part_count, [&](size_t part) {
+        for (std::vector<std::vector<BatchPosting>>& buckets : posting_buckets) {
+            for (const BatchPosting& posting : buckets[part]) {
+                const uint32_t word_count = word_counts[posting.document_index];
+                touched_postings[posting.touched_index]->Append(first_ordinal + static_cast<int>(posting.document_index), posting.term_count, word_count);
+                touched_statistics[posting.touched_index]->RaiseMaxTermFreq(posting.term_count * (1.0 / word_count));
+            }
+            buckets[part] = {};
+        }
+        });
+
+    std::vector<std::pair<int, int>> id_ordinals;
+    std::vector<int> ids;
+    std::vector<DocumentStatus> statuses;
+    std::vector<int> ratings;
+    std::vector<CopyOnWriteArray<DocumentTerm>> words_freqs;
+    for (size_t index = 0; index < documents.size(); ++index) {
+        const DocumentToAdd& document = documents[index];
+        id_ordinals.emplace_back(document.id, first_ordinal + static_cast<int>(index));
+        ids.push_back(document.id);
+        statuses.push_back(document.status);
+        ratings.push_back(ComputeAverageRating(document.ratings));
+        words_freqs.emplace_back(std::move(document_terms[index]));
+    }
+    document_ordinals_.InsertBatch(std::move(id_ordinals));
+    document_ids_.append(ids.begin(), ids.end());
+    document_statuses_.append(statuses.begin(), statuses.end());
+    document_ratings_.append(ratings.begin(), ratings.end());
+    document_to_words_freqs_.append(std::make_move_iterator(words_freqs.begin()), std::make_move_iterator(words_freqs.end()));
+    segment.ordinal_end = first_ordinal + static_cast<int>(documents.size());
+    corpus_generation_ = NextCorpusGeneration();
+    SealFullSegment();
 }
 
 int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
@@ -193,9 +897,10 @@ int SearchServer::ComputeAverageRating(const std::vector<int>& ratings) {
 }
 
 SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view word) const {
-    //,      (-)      (--)
-    if (word == "-" || (word.size() > 1 && word[1] == '-') || !IsValidWord(word)) {
-        throw std::invalid_argument("Query contains empty minus or several minuses before word or special characters.");
+    //,      (-)      (--);
+    //        
+    if (word == "-" || (word.size() > 1 && word[1] == '-')) {
+        throw std::invalid_argument("Query contains empty minus or several minuses before word.");
     }
     bool is_minus = false;
     if (word[0] == '-') {
@@ -211,121 +916,416 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view word) cons
 
 bool SearchServer::IsValidWord(const std::string_view word) {
     // A valid word must not contain special characters
-    return std::none_of(word.begin(), word.end(), [](char c) {
-        return c >= '\0' && c < ' ';
-        });
+    return !ContainsControlCharacters(word);
 }
 
-SearchServer::Query SearchServer::ParseQuery(const std::string_view text) const
+SearchServer::QueryLease SearchServer::ParseQuery(const std::string_view text) const
 {
-    Query query;
-    for (const std::string_view word : SplitIntoWords(text)) {
+    QueryLease query = ScratchPool<Query>::Acquire();
+    if (!SplitIntoValidWords(text, query->words)) {
+        throw std::invalid_argument("Query contains invalid characters");
+    }
+    for (const std::string_view word : query->words) {
         //      
         const QueryWord query_word = ParseQueryWord(word);
-        if (!query_word.is_stop) {
-            if (query_word.is_minus) {
-                query.minus_words.insert(query_word.data);
-            }
-            else {
-                query.plus_words.insert(query_word.data);
-            }
-            query.size++;
+        if (query_word.is_stop) {
+            continue;
+        }
+        const TermDictionary::TermId term_id = term_dictionary_.Find(query_word.data);
+        if (term_id == TermDictionary::NO_TERM) {
+            continue;
+        }
+        if (query_word.is_minus) {
+            query->minus_words.push_back(term_id);
+        }
+        else {
+            query->plus_words.push_back(term_id);
         }
     }
+    for (auto* term_ids : { &query->plus_words, &query->minus_words }) {
+        std::sort(term_ids->begin(), term_ids->end());
+        term_ids->erase(std::unique(term_ids->begin(), term_ids->end()), term_ids->end());
+    }
     return query;
 }
 
-SearchServer::Query_vector SearchServer::ParseQuery_Vector(const std::string_view text) const {
-    Query_vector query;
-    for (const std::string_view word : SplitIntoWords(text)) {
-        //      
-        const QueryWord query_word = ParseQueryWord(word);
-        if (!query_word.is_stop) {
-            if (query_word.is_minus) {
-                query.minus_words.push_back(query_word.data);
+// MatchDocument -     .      
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(Query const& query, int document_id) const {
+    const int ordinal = GetOrdinal(document_id);
+    const CopyOnWriteArray<DocumentTerm>& document_terms = document_to_words_freqs_[ordinal];
+
+    if (MatchDocumentTerms(query.minus_words, document_terms, nullptr)) {
+        return std::tuple{ std::vector<std::string_view>{}, document_statuses_[ordinal] };
+    }
+
+    std::vector<char> is_matched(query.plus_words.size());
+    MatchDocumentTerms(query.plus_words, document_terms, is_matched.data());
+    std::vector<std::string_view> result;
+    for (size_t i = 0; i < query.plus_words.size(); ++i) {
+        if (is_matched[i]) {
+            result.push_back(term_dictionary_.GetTerm(query.plus_words[i]));
+        }
+    }
+    std::sort(result.begin(), result.end());
+
+    return std::tuple{ result, document_statuses_[ordinal] };
+}
+
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::execution::parallel_policy&, const Query& query, int document_id) const {
+    const int ordinal = GetOrdinal(document_id);
+    const CopyOnWriteArray<DocumentTerm>& document_terms = document_to_words_freqs_[ordinal];
+    ThreadPool& thread_pool = GetThreadPool();
+
+    //      ,        is_matched
+    const auto check_words = [&](const std::vector<TermDictionary::TermId>& term_ids, std::vector<char>& is_matched) {
+        is_matched.assign(term_ids.size(), false);
+        const size_t part_count = std::max<size_t>(1u, std::min(thread_pool.GetThreadCount(), term_ids.size()));
+        const size_t part_size = term_ids.size() / part_count + 1;
+        thread_pool.ParallelFor(part_count, [&](size_t part) {
+            const size_t begin = std::min(term_ids.size(), part * part_size);
+            const size_t end = std::min(term_ids.size(), (part + 1) * part_size);
+            MatchDocumentTerms(std::span(term_ids).subspan(begin, end - begin), document_terms, is_matched.data() + begin);
+            });
+    };
+
+    std::vector<char> is_matched;
+    check_words(query.minus_words, is_matched);
+    if (std::find(is_matched.begin(), is_matched.end(), true) != is_matched.end()) {
+        return std::tuple{ std::vector<std::string_view>{}, document_statuses_[ordinal] };
+    }
+
+    check_words(query.plus_words, is_matched);
+    std::vector<std::string_view> result;
+    for (size_t i = 0; i < query.plus_words.size(); ++i) {
+        if (is_matched[i]) {
+            result.push_back(term_dictionary_.GetTerm(query.plus_words[i]));
+        }
+    }
+    std::sort(result.begin(), result.end());
+
+    return std::tuple{ result, document_statuses_[ordinal] };
+}
+
+bool SearchServer::MatchDocumentTerms(std::span<const TermDictionary::TermId> query_terms, const CopyOnWriteArray<DocumentTerm>& document_terms,
+    char* is_matched) {
+    //        ,     
+    constexpr size_t GALLOP_RATIO = 8;
+    const DocumentTerm* position = document_terms.begin();
+    const DocumentTerm* const end = document_terms.end();
+    const auto compare_term = [](const DocumentTerm& document_term, TermDictionary::TermId term_id) { return document_term.term_id < term_id; };
+    const bool is_galloping = document_terms.size() > query_terms.size() * GALLOP_RATIO;
+    bool is_any_matched = false;
+    for (size_t index = 0; index < query_terms.size() && position != end; ++index) {
+        const TermDictionary::TermId term_id = query_terms[index];
+        if (is_galloping) {
+            // ,     ,      
+            ptrdiff_t step = 1;
+            while (step < end - position && position[step].term_id < term_id) {
+                position += step;
+                step *= 2;
             }
-            else {
-                query.plus_words.push_back(query_word.data);
+            position = std::lower_bound(position, position + std::min(step + 1, end - position), term_id, compare_term);
+        }
+        else {
+            while (position != end && position->term_id < term_id) {
+                ++position;
+            }
+        }
+        if (position != end && position->term_id == term_id) {
+            if (is_matched == nullptr) {
+                return true;
             }
-            query.size++;
+            is_matched[index] = true;
+            is_any_matched = true;
         }
     }
-    return query;
+    return is_any_matched;
 }
 
-std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(Query const& query, int document_id) const {
-    CheckId(document_id);
+//  -   ,     
+void SearchServer::ExcludeMinusWords(ScoreAccumulator& accumulator, const Query& query) const {
+    for (const Segment& segment : segments_) {
+        for (const TermDictionary::TermId term_id : query.minus_words) {
+            const PostingList* postings = segment.FindPostingList(term_id);
+            if (postings == nullptr) {
+                continue;
+            }
+            postings->ForEach([&](int ordinal, double) {
+                accumulator.Exclude(ordinal);
+                });
+        }
+    }
+}
 
-    auto check_lambda = [&](auto&& word) { return word_to_document_freqs_.count(word) && word_to_document_freqs_.at(word).count(document_id); };
-    if (std::any_of(std::execution::seq, query.minus_words.begin(), query.minus_words.end(), check_lambda)) {
-        return std::tuple{ std::vector<std::string_view>{}, documents_.at(document_id).status };
+//   ,    ,  ,         .
+//           
+bool SearchServer::IsDocumentPartitioningPreferred(const Query& query, size_t part_count) const {
+    if (parallel_search_mode_ != ParallelSearchMode::AUTO) {
+        return parallel_search_mode_ == ParallelSearchMode::BY_DOCUMENTS;
+    }
+    if (part_count <= 1 || query.plus_words.size() < part_count * 4) {
+        return true;
     }
+    size_t total_postings = 0;
+    size_t max_postings = 0;
+    for (const TermDictionary::TermId term_id : query.plus_words) {
+        const size_t document_count = static_cast<size_t>(term_statistics_[term_id].document_count);
+        total_postings += document_count;
+        max_postings = std::max(max_postings, document_count);
+    }
+    return max_postings * part_count > total_postings;
+}
 
-    std::vector<std::string_view> matched_words(query.size);
+//             ,  
+//  ,    ,    ,    .   AUTO 
+// ,  ,    MIN_DOCUMENT_PART_POSTINGS ;  BY_DOCUMENTS    
+size_t SearchServer::GetDocumentPartCount(const Query& query, size_t thread_count) const {
+    const size_t max_part_count = std::max<size_t>(1u, thread_count);
+    if (parallel_search_mode_ != ParallelSearchMode::AUTO) {
+        return max_part_count;
+    }
+    size_t total_postings = 0;
+    for (const TermDictionary::TermId term_id : query.plus_words) {
+        total_postings += static_cast<size_t>(term_statistics_[term_id].document_count);
+    }
+    return std::clamp<size_t>(total_postings / MIN_DOCUMENT_PART_POSTINGS, 1u, max_part_count);
+}
 
-    std::copy_if(std::execution::seq,
-        query.plus_words.begin(), query.plus_words.end(),
-        matched_words.begin(), check_lambda);
+void SearchServer::CollectWordScores(TermDictionary::TermId term_id, const ScoreAccumulator& exclusions, std::vector<std::pair<int, double>>& scores) const {
+    if (term_statistics_[term_id].document_count == 0) {
+        return;
+    }
+    const double inverse_document_freq = ComputeWordInverseDocumentFreq(term_id);
+    for (const Segment& segment : segments_) {
+        const PostingList* postings = segment.FindPostingList(term_id);
+        if (postings == nullptr) {
+            continue;
+        }
+        visited_posting_count_ += postings->ForEach([&](int ordinal, double term_freq) {
+            if (!segment.IsRemoved(ordinal) && !exclusions.IsExcluded(ordinal)) {
+                scores.emplace_back(ordinal, term_freq * inverse_document_freq);
+            }
+            });
+    }
+}
+
+// IDF.         ;  
+//   ,            
+double SearchServer::ComputeWordInverseDocumentFreq(TermDictionary::TermId term_id) const {
+    const TermStatistics& statistics = term_statistics_[term_id];
+    return statistics.GetInverseDocumentFreq(corpus_generation_, [&] {
+        return log(GetDocumentCount() * 1.0 / statistics.document_count);
+        });
+}
 
-    auto it = std::find(std::execution::seq, matched_words.begin(), matched_words.end(), "");
-    while (it != matched_words.end()) {
-        matched_words.erase(it);
-        it = std::find(std::execution::seq, matched_words.begin(), matched_words.end(), "");
+double SearchServer::GetMaxTermFreq(TermDictionary::TermId term_id) const {
+    const TermStatistics& statistics = term_statistics_[term_id];
+    double max_term_freq = statistics.max_term_freq.load(std::memory_order_relaxed);
+    if (max_term_freq < 0.) {
+        max_term_freq = 0.;
+        for (const Segment& segment : segments_) {
+            if (const PostingList* postings = segment.FindPostingList(term_id)) {
+                postings->ForEach([&](int, double term_freq) {
+                    max_term_freq = std::max(max_term_freq, term_freq);
+                    });
+            }
+        }
+        statistics.max_term_freq.store(max_term_freq, std::memory_order_relaxed);
     }
+    return max_term_freq;
+}
 
-    std::vector<std::string_view> result(matched_words.size());
-    size_t number = 0;
-    for (const auto& word : matched_words) {
-        result[number] = ((*word_to_document_freqs_.find(word)).first);
-        ++number;
+double SearchServer::ComputeExactRelevance(int ordinal, const Query& query, const std::vector<double>& word_inverse_document_freqs) const {
+    const CopyOnWriteArray<DocumentTerm>& document_terms = document_to_words_freqs_[ordinal];
+    double relevance = 0.;
+    auto term_it = document_terms.begin();
+    for (size_t word_index = 0; word_index < query.plus_words.size() && term_it != document_terms.end(); ++word_index) {
+        const TermDictionary::TermId term_id = query.plus_words[word_index];
+        term_it = std::lower_bound(term_it, document_terms.end(), term_id,
+            [](const DocumentTerm& document_term, TermDictionary::TermId value) { return document_term.term_id < value; });
+        if (term_it != document_terms.end() && term_it->term_id == term_id) {
+            relevance += term_it->term_freq * word_inverse_document_freqs[word_index];
+        }
     }
+    return relevance;
+}
+
+// IDF    :           
+SearchServer::TermStatistics::TermStatistics(const TermStatistics& other)
+    : document_count(other.document_count)
+    , max_term_freq(other.max_term_freq.load(std::memory_order_relaxed))
+{}
 
-    return std::tuple{ result, documents_.at(document_id).status };
+SearchServer::TermStatistics& SearchServer::TermStatistics::operator=(const TermStatistics& other) {
+    document_count = other.document_count;
+    idf_generation.store(0, std::memory_order_relaxed);
+    max_term_freq.store(other.max_term_freq.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    return *this;
 }
 
-std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(const std::execution::parallel_policy&, Query_vector& query, int document_id) const {
-    CheckId(document_id);
-    
-    auto check_lambda = [&](auto&& word) { return word_to_document_freqs_.count(word) && word_to_document_freqs_.at(word).count(document_id); };
-    if (std::any_of(std::execution::par, query.minus_words.begin(), query.minus_words.end(), check_lambda)) {
-        return std::tuple{ std::vector<std::string_view>{}, documents_.at(document_id).status };
-    }
+SearchServer::TermStatistics::TermStatistics(TermStatistics&& other) noexcept
+    : TermStatistics(static_cast<const TermStatistics&>(other))
+{}
 
-    std::vector<std::string_view> matched_words(query.size);
+SearchServer::TermStatistics& SearchServer::TermStatistics::operator=(TermStatistics&& other) noexcept {
+    return *this = static_cast<const TermStatistics&>(other);
+}
 
-    std::copy_if(std::execution::par,
-        query.plus_words.begin(), query.plus_words.end(),
-        matched_words.begin(), check_lambda);
+void SearchServer::Segment::MarkRemoved(int ordinal) {
+    const size_t bit = static_cast<size_t>(ordinal - ordinal_begin);
+    tombstones.resize(bit / 64 + 1);
+    tombstones.Mutable(bit / 64) |= uint64_t{ 1 } << (bit % 64);
+    ++tombstone_count;
+}
 
-    std::sort(std::execution::par, matched_words.begin(), matched_words.end());
+//       ;         ,
+//        
+const SearchServer::Segment& SearchServer::FindSegment(int ordinal) const {
+    const auto it = std::upper_bound(segments_.begin(), segments_.end(), ordinal,
+        [](int value, const Segment& segment) { return value < segment.ordinal_begin; });
+    return *std::prev(it);
+}
 
-    matched_words.erase(std::unique(matched_words.begin(), matched_words.end()), matched_words.end());
+SearchServer::Segment& SearchServer::FindSegment(int ordinal) {
+    return const_cast<Segment&>(std::as_const(*this).FindSegment(ordinal));
+}
 
-    auto it = std::find(std::execution::par, matched_words.begin(), matched_words.end(), "");
-    if (it != matched_words.end())
-        matched_words.erase(it);
+void SearchServer::SealFullSegment() {
+    Segment& active_segment = segments_.back();
+    if (static_cast<size_t>(active_segment.ordinal_end - active_segment.ordinal_begin) < segment_capacity_) {
+        return;
+    }
+    //     ,     
+    for (size_t term_id = 0; term_id < active_segment.postings.size(); ++term_id) {
+        if (!active_segment.postings[term_id].empty()) {
+            active_segment.postings.Mutable(term_id).ShrinkToFit();
+        }
+    }
+    const int ordinal_end = active_segment.ordinal_end;
+    Segment& next_segment = segments_.emplace_back();
+    next_segment.ordinal_begin = ordinal_end;
+    next_segment.ordinal_end = ordinal_end;
+    if (auto_merge_segments_) {
+        MergeSegments();
+    }
+}
 
-    std::vector<std::string_view> result(matched_words.size());
-    std::transform(
-        std::execution::par,
-        matched_words.begin(), matched_words.end(),
-        result.begin(),
-        [&](const std::string_view word) {
-            return (*word_to_document_freqs_.find(word)).first;
-        });
+//      O(log N) ,     
+std::optional<std::pair<size_t, size_t>> SearchServer::PlanSegmentMerge() const {
+    const size_t last = segments_.size() - 1;
+    if (last >= 2) {
+        size_t first = last - 1;
+        size_t live_count = segments_[first].GetLiveCount();
+        while (first > 0 && segments_[first - 1].GetLiveCount() <= 2 * live_count) {
+            --first;
+            live_count += segments_[first].GetLiveCount();
+        }
+        if (last - first >= 2) {
+            return std::pair{ first, last };
+        }
+    }
+    for (size_t index = 0; index < last; ++index) {
+        const Segment& segment = segments_[index];
+        const size_t pending_count = segment.GetPendingRemovalCount();
+        if (pending_count > 0 && pending_count >= compaction_threshold_ * (segment.ordinal_end - segment.ordinal_begin)) {
+            return std::pair{ index, index + 1 };
+        }
+    }
+    return std::nullopt;
+}
 
-    return std::tuple{ result, documents_.at(document_id).status };
+//-  :      ,        
+bool SearchServer::MarkDocumentRemoved(int document_id) {
+    const int ordinal = document_ordinals_.Find(document_id);
+    if (ordinal == OrdinalMap::NO_ORDINAL) {
+        return false;
+    }
+    FindSegment(ordinal).MarkRemoved(ordinal);
+    auto& document_terms = document_to_words_freqs_.Mutable(ordinal);
+    for (const auto [term_id, _] : document_terms) {
+        --term_statistics_.Mutable(term_id).document_count;
+    }
+    document_terms = {};
+    document_ordinals_.Erase(document_id);
+    return true;
 }
 
-// IDF
-double SearchServer::ComputeWordInverseDocumentFreq(const std::string_view word) const {
-    return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+void SearchServer::CompactIfNeeded() {
+    if (auto_merge_segments_ && IsSegmentMergeNeeded()) {
+        MergeSegments();
+    }
+}
+
+std::vector<TermDictionary::TermId> SearchServer::GetMatchWordOrder(const Query& query) const {
+    std::vector<TermDictionary::TermId> plus_words = query.plus_words;
+    std::sort(plus_words.begin(), plus_words.end(), [this](TermDictionary::TermId lhs, TermDictionary::TermId rhs) {
+        return term_dictionary_.GetTerm(lhs) < term_dictionary_.GetTerm(rhs);
+        });
+    return plus_words;
+}
+
+//      .        ,
+//      ,       
+void SearchServer::MatchDocumentsChunk(const Query& query, const std::vector<TermDictionary::TermId>& plus_words, int ordinal_begin, int ordinal_end,
+    MatchedChunk& chunk) const {
+    const size_t chunk_size = static_cast<size_t>(ordinal_end - ordinal_begin);
+    chunk.excluded.assign((chunk_size + 63) / 64, 0);
+    chunk.match_counts.assign(chunk_size, 0);
+    chunk.matches.clear();
+    for (const Segment& segment : segments_) {
+        const int begin = std::max(ordinal_begin, segment.ordinal_begin);
+        const int end = std::min(ordinal_end, segment.ordinal_end);
+        if (begin >= end) {
+            continue;
+        }
+        for (const TermDictionary::TermId term_id : query.minus_words) {
+            if (const PostingList* postings = segment.FindPostingList(term_id)) {
+                postings->ForEach(begin, end, [&](int ordinal, double) {
+                    const size_t offset = static_cast<size_t>(ordinal - ordinal_begin);
+                    chunk.excluded[offset / 64] |= uint64_t{ 1 } << (offset % 64);
+                    });
+            }
+        }
+        for (uint32_t word = 0; word < plus_words.size(); ++word) {
+            const PostingList* postings = segment.FindPostingList(plus_words[word]);
+            if (postings == nullptr) {
+                continue;
+            }
+            postings->ForEach(begin, end, [&](int ordinal, double) {
+                const size_t offset = static_cast<size_t>(ordinal - ordinal_begin);
+                if ((chunk.excluded[offset / 64] >> (offset % 64) & 1) == 0 && !segment.IsRemoved(ordinal)) {
+                    chunk.matches.push_back({ static_cast<uint32_t>(offset), word });
+                    ++chunk.match_counts[offset];
+                }
+                });
+        }
+    }
+
+    chunk.ordinals.clear();
+    chunk.word_offsets.assign(1, 0);
+    uint32_t word_count = 0;
+    for (size_t offset = 0; offset < chunk_size; ++offset) {
+        if (chunk.match_counts[offset] == 0) {
+            continue;
+        }
+        chunk.ordinals.push_back(ordinal_begin + static_cast<int>(offset));
+        const uint32_t match_count = chunk.match_counts[offset];
+        chunk.match_counts[offset] = word_count;
+        word_count += match_count;
+        chunk.word_offsets.push_back(word_count);
+    }
+    chunk.words.resize(word_count);
+    for (const auto& [offset, word] : chunk.matches) {
+        chunk.words[chunk.match_counts[offset]++] = term_dictionary_.GetTerm(plus_words[word]);
+    }
 }
 
-void SearchServer::CheckId(int document_id) const {
-    if (document_id < 0 || document_to_words_freqs_.count(document_id) == 0) {
+int SearchServer::GetOrdinal(int document_id) const {
+    const int ordinal = document_ordinals_.Find(document_id);
+    if (ordinal == OrdinalMap::NO_ORDINAL) {
         throw std::out_of_range("The index is wrong");
     }
+    return ordinal;
 }
 
 //--additional functions:
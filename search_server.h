@@ -1,7 +1,6 @@
 #pragma once
 #include <string>
 #include <map>
-#include <unordered_map>
 #include <vector>
 #include <set>
 #include <stdexcept>
@@ -9,17 +8,67 @@
 #include <execution>
 #include <string_view>
 #include <thread>
-#include <future>
+#include <memory>
+#include <limits>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <iterator>
+#include <cstddef>
+#include <functional>
+#include <bit>
+#include <utility>
+#include <span>
 
 #include "document.h"
 #include "string_processing.h"
-#include "concurrent_map.h"
+#include "top_documents.h"
+#include "score_accumulator.h"
+#include "thread_pool.h"
+#include "term_dictionary.h"
+#include "result_cache.h"
+#include "scratch_pool.h"
+#include "copy_on_write_array.h"
+#include "persistent_array.h"
+#include "ordinal_map.h"
+#include "posting_list.h"
+#include "snapshot.h"
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
-constexpr double INACCURACY = 1e-6;
+//число документов, после которого изменяемый сегмент индекса запечатывается
+const size_t DEFAULT_SEGMENT_CAPACITY = 1 << 16;
+//доля удалённых документов запечатанного сегмента, записи которых ещё лежат в листах, после которой сегмент перестраивается
+const double DEFAULT_COMPACTION_THRESHOLD = 0.25;
+
+//разбиение работы параллельного поиска между задачами: по плюс-словам запроса или по диапазонам документов.
+//AUTO выбирает способ для каждого запроса отдельно
+enum class ParallelSearchMode {
+    AUTO,
+    BY_TERMS,
+    BY_DOCUMENTS,
+};
+
+//отбор лучших документов: EXHAUSTIVE суммирует релевантность по всем записям постинг-листов плюс-слов,
+//MAX_SCORE обходит документы по возрастанию номера и пропускает те, что по верхним оценкам TF-IDF слов
+//не могут войти в выдачу. Результаты совпадают
+enum class ScoringMode {
+    EXHAUSTIVE,
+    MAX_SCORE,
+};
+
+//документ для пакетного добавления методом AddDocuments; текст должен жить до конца вызова
+struct DocumentToAdd {
+    int id = 0;
+    std::string_view text;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::vector<int> ratings;
+};
 
 class SearchServer {
 public:
+    //подготовленное слияние сегментов, см. PrepareSegmentMerge
+    struct SegmentMerge;
+
     //constructors
     SearchServer() = default;
     explicit SearchServer(const std::string& set_stop_words);
@@ -38,6 +87,13 @@ public:
 
     void AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
 
+    //пакетное добавление: документы разбираются на слова параллельно, инвертированный индекс достраивается одним проходом.
+    //Ошибки те же, что у AddDocument, но пакет добавляется целиком или не добавляется вовсе.
+    //Без политики используется параллельная версия
+    void AddDocuments(const std::vector<DocumentToAdd>& documents);
+    void AddDocuments(const std::execution::sequenced_policy&, const std::vector<DocumentToAdd>& documents);
+    void AddDocuments(const std::execution::parallel_policy&, const std::vector<DocumentToAdd>& documents);
+
     //ñîðòèðîâêà èòîãîâûõ äîêóìåíòîâ ïî ðåéòèíãó è îòñå÷åíèå ÒÎÏ-5 äîêóìåíòîâ
     //ïðèíèìàåò çàïðîñ è ôóíêòîð
     template < typename DocumentPredicate, class ExecutionPolicy>
@@ -55,40 +111,280 @@ public:
     std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, DocumentStatus required_status) const;
     std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentStatus required_status) const;
 
+    //FindTopDocuments для окна выдачи: count документов, начиная с позиции offset в общем порядке выдачи.
+    //Отбираются только offset + count лучших документов, полной сортировки результатов нет
+    template < typename DocumentPredicate, class ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, const DocumentPredicate& document_predicate, size_t offset, size_t count) const;
+    template< typename DocumentPredicate >
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, const DocumentPredicate& document_predicate, size_t offset, size_t count) const;
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentStatus required_status, size_t offset, size_t count) const;
+
     size_t GetDocumentCount() const;
 
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::string_view raw_query, int document_id) const;
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::sequenced_policy&, const std::string_view raw_query, int document_id) const;
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::parallel_policy&, const std::string_view raw_query, int document_id) const;
 
+    //все документы в порядке id, для документов без совпадений - пустой список слов
     std::vector<std::tuple<int, std::vector<std::string_view>, DocumentStatus>> MatchDocuments(const std::string_view raw_query) const;
-
-    const std::map<std::string, double, std::less<>>& GetWordFrequencies(int document_id) const;
+    //сопоставление запроса со всем корпусом обходом постинг-листов его слов, без перебора документов.
+    //function(document_id, words, status) вызывается в вызывающем потоке в порядке добавления документов и только
+    //для документов, в которых есть плюс-слово и нет минус-слов. words - совпавшие слова в лексикографическом порядке,
+    //как в MatchDocument, и действительны до возврата из function. Корпус обрабатывается частями,
+    //поэтому память не растёт с числом совпавших документов
+    template <typename Function>
+    void MatchDocuments(const std::execution::sequenced_policy&, const std::string_view raw_query, Function function) const;
+    template <typename Function>
+    void MatchDocuments(const std::execution::parallel_policy&, const std::string_view raw_query, Function function) const;
+
+    //частоты слов документа; строки-ключи принадлежат словарю сервера и действительны всё время его жизни
+    std::map<std::string_view, double> GetWordFrequencies(int document_id) const;
+    //номера термов документа в порядке возрастания, пустой вектор для неизвестного id
+    std::vector<TermDictionary::TermId> GetDocumentTermIds(int document_id) const;
 
     //int GetDocumentId(int index) const;
 
-    std::vector<int>::iterator begin();
+    //перебор id документов в порядке добавления; удалённые документы пропускаются по битовым картам сегментов
+    class DocumentIdIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = int;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const int*;
+        using reference = const int&;
+
+        DocumentIdIterator() = default;
+
+        reference operator*() const {
+            return server_->document_ids_[ordinal_];
+        }
+
+        pointer operator->() const {
+            return &**this;
+        }
+
+        DocumentIdIterator& operator++() {
+            ++ordinal_;
+            SkipRemoved();
+            return *this;
+        }
+
+        DocumentIdIterator operator++(int) {
+            DocumentIdIterator previous = *this;
+            ++*this;
+            return previous;
+        }
+
+        bool operator==(const DocumentIdIterator& other) const {
+            return ordinal_ == other.ordinal_;
+        }
+
+    private:
+        friend class SearchServer;
+
+        DocumentIdIterator(const SearchServer* server, int ordinal)
+            : server_(server)
+            , ordinal_(ordinal)
+        {
+            SkipRemoved();
+        }
+
+        void SkipRemoved();
+
+        const SearchServer* server_ = nullptr;
+        int ordinal_ = 0;
+        size_t segment_index_ = 0;
+    };
+
+    DocumentIdIterator begin() const;
 
-    std::vector<int>::iterator end();
+    DocumentIdIterator end() const;
 
+    //удаление логическое и не трогает постинг-листы: документ отмечается в битовой карте сегмента,
+    //у его слов уменьшается число документов. Записи удалённых документов отбрасываются при перестройке сегментов
     void RemoveDocument(int document_id);
     void RemoveDocument(const std::execution::sequenced_policy&, int document_id);
     void RemoveDocument(const std::execution::parallel_policy&, int document_id);
+    //пакетное удаление: одна смена поколения корпуса и одна проверка порога перестройки на весь пакет.
+    //Неизвестные id пропускаются
+    void RemoveDocuments(const std::vector<int>& document_ids);
+
+    //пул потоков для параллельных версий методов и ProcessQueries. Пул может разделяться несколькими серверами,
+    //без явной установки используется ThreadPool::GetDefault()
+    void SetThreadPool(std::shared_ptr<ThreadPool> thread_pool);
+    ThreadPool& GetThreadPool() const;
+
+    void SetParallelSearchMode(ParallelSearchMode mode);
+    //MAX_SCORE используется последовательным поиском и параллельным при разбиении по документам
+    void SetScoringMode(ScoringMode mode);
+    //для профилирования: число записей постинг-листов, прочитанных поиском в текущем потоке за всё время
+    static uint64_t GetVisitedPostingCount();
+
+    //кэш результатов FindTopDocuments со статусом документов или без него; запросы с предикатом не кэшируются.
+    //Кэш может разделяться несколькими серверами и копиями сервера, nullptr отключает кэширование
+    void SetResultCache(std::shared_ptr<ResultCache> result_cache);
+    const std::shared_ptr<ResultCache>& GetResultCache() const;
+
+    //снимок сервера в двоичном файле: стоп-слова, словарь термов, постинг-листы, данные и частоты слов документов.
+    //Удалённые документы в снимок не попадают, порядковые номера документов в нём идут подряд
+    void SaveSnapshot(const std::string& path) const;
+    //сервер отвечает на запросы прямо из отображённого в память файла снимка, словарь и индексы не разбираются.
+    //Изменение сервера копирует в память только затронутые постинг-листы и документы.
+    //Ошибки чтения и повреждённый файл - std::runtime_error
+    static SearchServer LoadSnapshot(const std::string& path, SnapshotVerification verification = SnapshotVerification::FULL);
+
+    //индекс делится на сегменты: новые документы дописываются в изменяемый сегмент, заполненный сегмент запечатывается
+    //и больше не меняется. Удаление только отмечает документ в битовой карте его сегмента,
+    //записи удалённых документов отбрасываются при слиянии соседних запечатанных сегментов
+    void SetSegmentCapacity(size_t document_count);
+    //число сегментов вместе с изменяемым
+    size_t GetSegmentCount() const;
+    //без автоматического слияния сегменты сливаются только методами MergeSegments и ApplySegmentMerge,
+    //например фоновой задачей ConcurrentSearchServer
+    void SetAutoMergeSegments(bool auto_merge);
+    //сливает соседние запечатанные сегменты близкого размера, пока есть что сливать
+    void MergeSegments();
+    bool IsSegmentMergeNeeded() const;
+    //слияние в два этапа: долгое построение общего сегмента по закреплённой копии сервера
+    //и быстрое применение к более новой копии. nullopt, если сливать нечего
+    std::optional<SegmentMerge> PrepareSegmentMerge() const;
+    //false, если исходные сегменты уже изменены другим слиянием. Удаления, сделанные после подготовки, сохраняются
+    bool ApplySegmentMerge(SegmentMerge merge);
+    //запечатанный сегмент, у которого доля удалённых документов с записями в листах не меньше ratio,
+    //перестраивается при слиянии сегментов, даже если сливать его не с чем
+    void SetCompactionThreshold(double ratio);
+    //перестраивает листы всех сегментов с удалёнными документами независимо от порога; изменяемый сегмент запечатывается
+    void Compact();
+    //число удалённых документов, записи которых ещё лежат в постинг-листах
+    size_t GetPendingRemovalCount() const;
+    //байты сжатых постинг-листов всех сегментов вместе с объектами листов
+    size_t GetPostingMemoryUsage() const;
 
 private:
-    struct DocumentData {
-        int rating = 0;
-        DocumentStatus status;
+    // сегмент индекса: постинг-листы документов с порядковыми номерами [ordinal_begin, ordinal_end).
+    // Номера выдаются по возрастанию, поэтому новые записи всегда дописываются в конец листа.
+    // Копии сервера разделяют листы и битовые карты сегментов, изменение копирует только путь к изменённому листу.
+    // Записи удалённых документов остаются в листах до слияния и отмечаются в битовой карте tombstones
+    struct Segment {
+        int ordinal_begin = 0;
+        int ordinal_end = 0;
+        // листы по номеру терма; термов с номерами от размера массива в сегменте нет
+        PersistentArray<PostingList> postings;
+        // бит на каждый порядковый номер сегмента
+        PersistentArray<uint64_t> tombstones;
+        size_t tombstone_count = 0;
+        // удалённые документы, записи которых уже отброшены при перестройке
+        size_t purged_count = 0;
+
+        //лист терма или nullptr, если в сегменте слово не встречается
+        const PostingList* FindPostingList(TermDictionary::TermId term_id) const {
+            return term_id < postings.size() && !postings[term_id].empty() ? &postings[term_id] : nullptr;
+        }
+
+        bool IsRemoved(int ordinal) const {
+            const size_t bit = static_cast<size_t>(ordinal - ordinal_begin);
+            return tombstone_count != 0 && bit / 64 < tombstones.size() && (tombstones[bit / 64] >> (bit % 64) & 1) != 0;
+        }
+
+        void MarkRemoved(int ordinal);
+
+        size_t GetLiveCount() const {
+            return static_cast<size_t>(ordinal_end - ordinal_begin) - tombstone_count;
+        }
+
+        size_t GetPendingRemovalCount() const {
+            return tombstone_count - purged_count;
+        }
+    };
+
+    // статистика слова по всему корпусу: число живых документов с ним и IDF, вычисленный для поколения корпуса idf_generation.
+    // Любое изменение корпуса меняет поколение, и IDF пересчитывается при первом обращении.
+    // Копии сервера разделяют статистику неизменённых слов, поэтому кэш IDF может заполняться для разных поколений сразу
+    // Наибольшая частота слова в документах - основа верхней оценки для MAX_SCORE; отрицательна, пока не вычислена.
+    // Удаление документов её не уменьшает, оценка остаётся верхней
+    struct TermStatistics {
+        int document_count = 0;
+        mutable std::atomic<double> inverse_document_freq{ 0. };
+        mutable std::atomic<uint64_t> idf_generation{ 0 };
+        mutable std::atomic<double> max_term_freq{ -1. };
+
+        static constexpr uint64_t IDF_LOCKED = std::numeric_limits<uint64_t>::max();
+
+        //новая запись листа; неизвестная наибольшая частота останется неизвестной до первого запроса
+        void RaiseMaxTermFreq(double term_freq) {
+            if (term_freq > max_term_freq.load(std::memory_order_relaxed) && max_term_freq.load(std::memory_order_relaxed) >= 0.) {
+                max_term_freq.store(term_freq, std::memory_order_relaxed);
+            }
+        }
+
+        //IDF поколения generation из кэша или вычисленный compute(). Значение и поколение публикуются вместе:
+        //запись захватывает кэш, заменяя поколение на IDF_LOCKED, чтение перепроверяет поколение после значения
+        template <typename Compute>
+        double GetInverseDocumentFreq(uint64_t generation, Compute compute) const {
+            uint64_t cached_generation = idf_generation.load(std::memory_order_acquire);
+            if (cached_generation == generation) {
+                const double value = inverse_document_freq.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                cached_generation = idf_generation.load(std::memory_order_relaxed);
+                if (cached_generation == generation) {
+                    return value;
+                }
+            }
+            const double value = compute();
+            if (cached_generation != IDF_LOCKED && idf_generation.compare_exchange_strong(cached_generation, IDF_LOCKED, std::memory_order_relaxed)) {
+                std::atomic_thread_fence(std::memory_order_release);
+                inverse_document_freq.store(value, std::memory_order_relaxed);
+                idf_generation.store(generation, std::memory_order_release);
+            }
+            return value;
+        }
+
+        TermStatistics() = default;
+        TermStatistics(const TermStatistics& other);
+        TermStatistics& operator=(const TermStatistics& other);
+        TermStatistics(TermStatistics&& other) noexcept;
+        TermStatistics& operator=(TermStatistics&& other) noexcept;
+    };
+
+    // слово документа: номер терма и частота слова в документе
+    struct DocumentTerm {
+        TermDictionary::TermId term_id = 0;
+        double term_freq = 0.;
     };
 
     std::set<std::string, std::less<>> stop_words_;
     // ÷àñòîòà ñëîâà â êàæäîì äîêóìåíòå
-    std::unordered_map<std::string_view, std::map<int, double>> word_to_document_freqs_;
+    TermDictionary term_dictionary_;
+    // сегменты по возрастанию порядковых номеров, последний - изменяемый
+    std::vector<Segment> segments_ = std::vector<Segment>(1);
+    // статистика слов по номеру терма
+    PersistentArray<TermStatistics> term_statistics_;
     // ÷àñòîòû êàæäîãî ñëîâà â äîêóìåíòå
-    std::unordered_map<int, std::map<std::string, double, std::less<>>> document_to_words_freqs_;
-    std::map<int, DocumentData> documents_;
-    //âåêòîð ids äëÿ ôóíêöèé begin è end
-    std::vector<int> ids_;
+    // (слова документа отсортированы по номеру терма)
+    PersistentArray<CopyOnWriteArray<DocumentTerm>> document_to_words_freqs_;
+    // внешний id документа -> внутренний порядковый номер
+    OrdinalMap document_ordinals_;
+    // данные документов по порядковому номеру, номер удалённого документа повторно не выдаётся
+    PersistentArray<int> document_ids_;
+    PersistentArray<DocumentStatus> document_statuses_;
+    PersistentArray<int> document_ratings_;
+
+    std::shared_ptr<ThreadPool> thread_pool_;
+    std::shared_ptr<ResultCache> result_cache_;
+    //файл снимка, на который ссылаются словарь и индексы загруженного сервера и его копий
+    std::shared_ptr<const MappedFile> snapshot_file_;
+    ParallelSearchMode parallel_search_mode_ = ParallelSearchMode::AUTO;
+    ScoringMode scoring_mode_ = ScoringMode::EXHAUSTIVE;
+    size_t segment_capacity_ = DEFAULT_SEGMENT_CAPACITY;
+    bool auto_merge_segments_ = true;
+    double compaction_threshold_ = DEFAULT_COMPACTION_THRESHOLD;
+    // номер поколения корпуса, новый при каждом добавлении и удалении документа.
+    // Номера выдаются общим счётчиком, поэтому разные серверы и разошедшиеся копии не получат одинаковых
+    uint64_t corpus_generation_ = NextCorpusGeneration();
+
+    static uint64_t NextCorpusGeneration();
+
+    static thread_local uint64_t visited_posting_count_;
 
     bool IsStopWord(const std::string_view word) const;
 
@@ -96,6 +392,25 @@ private:
 
     static int ComputeAverageRating(const std::vector<int>& ratings);
 
+    //общая часть AddDocuments: при thread_pool == nullptr все этапы выполняются в вызывающем потоке
+    void AddDocumentsBatch(const std::vector<DocumentToAdd>& documents, ThreadPool* thread_pool);
+
+    //сегмент, которому принадлежит порядковый номер
+    const Segment& FindSegment(int ordinal) const;
+    Segment& FindSegment(int ordinal);
+    //запечатывает заполненный изменяемый сегмент и при автоматическом слиянии сливает запечатанные
+    void SealFullSegment();
+    //диапазон [first, last) соседних запечатанных сегментов для слияния: последние сегменты, среди которых
+    //каждый более старый не больше чем вдвое превосходит сумму живых документов более новых.
+    //Если таких нет - один сегмент, доля удалённых документов которого достигла порога перестройки
+    std::optional<std::pair<size_t, size_t>> PlanSegmentMerge() const;
+    //общий сегмент из сегментов [first, last) без записей удалённых документов
+    SegmentMerge BuildSegmentMerge(size_t first, size_t last) const;
+    //отмечает документ удалённым; false, если документа нет
+    bool MarkDocumentRemoved(int document_id);
+    //после удалений: при автоматическом слиянии перестраивает сегменты, достигшие порога
+    void CompactIfNeeded();
+
     struct QueryWord {
         std::string_view data;
         bool is_minus;
@@ -106,43 +421,212 @@ private:
 
     static bool IsValidWord(const std::string_view word);
 
+    //слова запроса переводятся в номера термов один раз при разборе: без повторов, по возрастанию номера.
+    //Слов, которых нет в словаре, нет ни в одном документе, поэтому в запрос они не попадают
     struct Query {
-        std::set<std::string_view> plus_words;
-        std::set<std::string_view> minus_words;
-
-        size_t size = 0;
-
-        std::string data_;
-    };
-
-    struct Query_vector {
-
-        std::vector<std::string_view> plus_words;
-        std::vector<std::string_view> minus_words;
-
-        size_t size = 0;
+        std::vector<TermDictionary::TermId> plus_words;
+        std::vector<TermDictionary::TermId> minus_words;
+        //буфер слов исходного текста запроса
+        std::vector<std::string_view> words;
+
+        void Clear() {
+            plus_words.clear();
+            minus_words.clear();
+            words.clear();
+        }
     };
+    using QueryLease = ScratchPool<Query>::Lease;
 
-    Query ParseQuery(const std::string_view text) const;
-    Query_vector ParseQuery_Vector(const std::string_view text) const;
+    //запрос разбирается во временный буфер потока, поэтому в установившемся режиме разбор не выделяет память.
+    //Один разобранный запрос используется всеми версиями FindTopDocuments и MatchDocument
+    QueryLease ParseQuery(const std::string_view text) const;
 
     //âû÷èñëåíèå IDF
-    double ComputeWordInverseDocumentFreq(const std::string_view word) const;
+    double ComputeWordInverseDocumentFreq(TermDictionary::TermId term_id) const;
+    //наибольшая частота слова среди записей его листов, вычисляется при первом обращении
+    double GetMaxTermFreq(TermDictionary::TermId term_id) const;
 
     //ïîèñê äîêóìåíòîâ ïî ïîäãîòîâëåííîìó çàïðîñó è çàäàííûì ïàðàìåòðàì
-    template <typename Container, typename It, typename DocumentPredicate>
-    void ComputeDocumentRelevance(Container& result_container, It range_begin, It range_end, DocumentPredicate document_predicate) const;
+    void ExcludeMinusWords(ScoreAccumulator& accumulator, const Query& query) const;
+    //суммирует TF-IDF слов диапазона в accumulator для документов с порядковыми номерами из [ordinal_begin, ordinal_end);
+    //документы, исключённые в exclusions, пропускаются
+    template <typename It, typename DocumentPredicate>
+    void ComputeDocumentRelevance(ScoreAccumulator& accumulator, const ScoreAccumulator& exclusions, It range_begin, It range_end,
+        int ordinal_begin, int ordinal_end, DocumentPredicate document_predicate) const;
+    bool IsDocumentPartitioningPreferred(const Query& query, size_t part_count) const;
+    //число задач при разбиении по документам
+    size_t GetDocumentPartCount(const Query& query, size_t thread_count) const;
+    //в режиме AUTO задача, делящая поиск по документам, получает не меньше стольких записей листов
+    static constexpr size_t MIN_DOCUMENT_PART_POSTINGS = 4096;
+    //вклады слова (порядковый номер, TF-IDF) по возрастанию номера для документов, не удалённых и не исключённых в exclusions
+    void CollectWordScores(TermDictionary::TermId term_id, const ScoreAccumulator& exclusions, std::vector<std::pair<int, double>>& scores) const;
+    //вклады слов запроса при разбиении параллельного поиска по словам, по одному списку на плюс-слово
+    struct WordScoresScratch {
+        std::vector<std::vector<std::pair<int, double>>> words;
+
+        void Clear() {
+            for (auto& scores : words) {
+                scores.clear();
+            }
+        }
+    };
+
+    //курсор MAX_SCORE: непросмотренная часть листа слова в сегменте и верхняя оценка вклада слова
+    struct MaxScoreCursor {
+        PostingCursor postings;
+        double inverse_document_freq = 0.;
+        double upper_bound = 0.;
+    };
+    //лист слова запроса в сегменте до создания курсоров: курсоры упорядочиваются по верхней оценке
+    struct MaxScoreTerm {
+        const PostingList* postings = nullptr;
+        double inverse_document_freq = 0.;
+        double upper_bound = 0.;
+    };
+    //окно порядковых номеров, в котором основные слова суммируются без обхода документов по одному
+    static constexpr int MAX_SCORE_WINDOW = 4096;
+    struct MaxScoreScratch {
+        std::vector<MaxScoreTerm> terms;
+        std::vector<MaxScoreCursor> cursors;
+        //суммы верхних оценок курсоров, упорядоченных по возрастанию оценки
+        std::vector<double> bound_sums;
+        //IDF слов запроса в порядке запроса для точного подсчёта релевантности
+        std::vector<double> word_inverse_document_freqs;
+        //суммы основных слов в окне и битовая карта затронутых документов окна
+        std::vector<double> window_scores = std::vector<double>(MAX_SCORE_WINDOW);
+        std::vector<uint64_t> window_documents = std::vector<uint64_t>(MAX_SCORE_WINDOW / 64);
+
+        void Clear() {
+            terms.clear();
+            cursors.clear();
+            bound_sums.clear();
+            word_inverse_document_freqs.clear();
+        }
+    };
+    //релевантность по словам документа из прямого индекса: слагаемые и порядок сложения те же, что при полном подсчёте
+    double ComputeExactRelevance(int ordinal, const Query& query, const std::vector<double>& word_inverse_document_freqs) const;
+    //MAX_SCORE: добавляет в top_documents документы с порядковыми номерами из [ordinal_begin, ordinal_end).
+    //Слова делятся на неосновные - с наименьшими оценками, сумма которых ниже порога входа в выдачу, - и основные.
+    //Листы основных слов суммируются по окнам номеров, как при полном подсчёте, а листы неосновных
+    //проверяются поиском только для документов окна, которые ещё могут войти в выдачу.
+    //С ростом порога основных слов становится меньше
+    template <typename DocumentPredicate>
+    void CollectTopDocumentsPruned(TopDocuments& top_documents, const ScoreAccumulator& exclusions, const Query& query,
+        int ordinal_begin, int ordinal_end, DocumentPredicate document_predicate) const;
+    //возвращают top_count лучших документов в порядке выдачи, остальные отбрасываются сразу при отборе
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const std::execution::sequenced_policy&, const Query& query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindAllDocuments(const std::execution::sequenced_policy&, const Query& query, DocumentPredicate document_predicate, size_t top_count) const;
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const std::execution::parallel_policy&, const Query& query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindAllDocuments(const std::execution::parallel_policy&, const Query& query, DocumentPredicate document_predicate, size_t top_count) const;
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const;
+    std::vector<Document> FindAllDocuments(const Query& query, DocumentPredicate document_predicate, size_t top_count) const;
+    //окно выдачи [offset, offset + count) по разобранному запросу
+    template <typename DocumentPredicate, class ExecutionPolicy>
+    std::vector<Document> FindTopDocumentsWindow(ExecutionPolicy&& policy, const Query& query, const DocumentPredicate& document_predicate, size_t offset, size_t count) const;
+    //поиск по статусу документов через кэш результатов, если он задан
+    template <class ExecutionPolicy>
+    std::vector<Document> FindTopDocumentsByStatus(ExecutionPolicy&& policy, const std::string_view raw_query, DocumentStatus required_status, size_t offset, size_t count) const;
 
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(Query const& query, int document_id) const;
-    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::parallel_policy&, Query_vector& query, int document_id) const;
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::execution::parallel_policy&, const Query& query, int document_id) const;
+    //отмечает в is_matched[i], есть ли query_terms[i] среди слов документа, и возвращает, нашлось ли хоть одно слово.
+    //Без is_matched поиск останавливается на первом найденном слове. Оба массива упорядочены по номеру терма;
+    //если документ намного длиннее списка слов, слова ищутся галопом от места предыдущего, иначе массивы сливаются
+    static bool MatchDocumentTerms(std::span<const TermDictionary::TermId> query_terms, const CopyOnWriteArray<DocumentTerm>& document_terms,
+        char* is_matched);
+
+    //совпадения запроса в части корпуса: документ ordinals[i] совпал словами words[word_offsets[i], word_offsets[i + 1])
+    struct MatchedChunk {
+        std::vector<int> ordinals;
+        std::vector<uint32_t> word_offsets;
+        std::vector<std::string_view> words;
+        //рабочие массивы: исключённые минус-словами документы, число совпавших слов документа
+        //и пары (смещение документа в части, номер слова)
+        std::vector<uint64_t> excluded;
+        std::vector<uint32_t> match_counts;
+        std::vector<std::pair<uint32_t, uint32_t>> matches;
+    };
+    //порядковых номеров в части корпуса
+    static constexpr int MATCH_CHUNK_SIZE = 16384;
+    //плюс-слова запроса в лексикографическом порядке - в этом порядке MatchDocument выдаёт совпавшие слова
+    std::vector<TermDictionary::TermId> GetMatchWordOrder(const Query& query) const;
+    //совпадения документов с порядковыми номерами из [ordinal_begin, ordinal_end)
+    void MatchDocumentsChunk(const Query& query, const std::vector<TermDictionary::TermId>& plus_words, int ordinal_begin, int ordinal_end,
+        MatchedChunk& chunk) const;
+    //function(chunk) для частей корпуса по порядку
+    template <typename Function>
+    void ForEachMatchedChunk(const std::execution::sequenced_policy&, const Query& query, Function&& function) const;
+    //части обрабатываются волнами по несколько на поток пула, function вызывается для частей волны по порядку
+    template <typename Function>
+    void ForEachMatchedChunk(const std::execution::parallel_policy&, const Query& query, Function&& function) const;
+    template <typename Function>
+    void ForEachMatchedDocument(const MatchedChunk& chunk, Function& function) const;
+
+    int GetOrdinal(int document_id) const;
+};
+
+//======== MatchDocuments ========
+
+template <typename Function>
+void SearchServer::MatchDocuments(const std::execution::sequenced_policy&, const std::string_view raw_query, Function function) const {
+    const QueryLease query = ParseQuery(raw_query);
+    ForEachMatchedChunk(std::execution::seq, *query, [&](const MatchedChunk& chunk) {
+        ForEachMatchedDocument(chunk, function);
+        });
+}
 
-    void CheckId(int document_id) const;
+template <typename Function>
+void SearchServer::MatchDocuments(const std::execution::parallel_policy&, const std::string_view raw_query, Function function) const {
+    const QueryLease query = ParseQuery(raw_query);
+    ForEachMatchedChunk(std::execution::par, *query, [&](const MatchedChunk& chunk) {
+        ForEachMatchedDocument(chunk, function);
+        });
+}
+
+template <typename Function>
+void SearchServer::ForEachMatchedChunk(const std::execution::sequenced_policy&, const Query& query, Function&& function) const {
+    const std::vector<TermDictionary::TermId> plus_words = GetMatchWordOrder(query);
+    const int ordinal_end = static_cast<int>(document_ids_.size());
+    MatchedChunk chunk;
+    for (int ordinal = 0; ordinal < ordinal_end; ordinal += MATCH_CHUNK_SIZE) {
+        MatchDocumentsChunk(query, plus_words, ordinal, std::min(ordinal_end, ordinal + MATCH_CHUNK_SIZE), chunk);
+        function(static_cast<const MatchedChunk&>(chunk));
+    }
+}
+
+template <typename Function>
+void SearchServer::ForEachMatchedChunk(const std::execution::parallel_policy&, const Query& query, Function&& function) const {
+    const std::vector<TermDictionary::TermId> plus_words = GetMatchWordOrder(query);
+    const int ordinal_end = static_cast<int>(document_ids_.size());
+    const size_t chunk_count = (static_cast<size_t>(ordinal_end) + MATCH_CHUNK_SIZE - 1) / MATCH_CHUNK_SIZE;
+    ThreadPool& thread_pool = GetThreadPool();
+    std::vector<MatchedChunk> chunks(std::min(chunk_count, std::max<size_t>(1u, thread_pool.GetThreadCount() * 2)));
+    for (size_t first = 0; first < chunk_count; first += chunks.size()) {
+        const size_t wave_size = std::min(chunks.size(), chunk_count - first);
+        thread_pool.ParallelFor(wave_size, [&](size_t index) {
+            const int ordinal_begin = static_cast<int>((first + index) * MATCH_CHUNK_SIZE);
+            MatchDocumentsChunk(query, plus_words, ordinal_begin, std::min(ordinal_end, ordinal_begin + MATCH_CHUNK_SIZE), chunks[index]);
+            });
+        for (size_t index = 0; index < wave_size; ++index) {
+            function(static_cast<const MatchedChunk&>(chunks[index]));
+        }
+    }
+}
+
+template <typename Function>
+void SearchServer::ForEachMatchedDocument(const MatchedChunk& chunk, Function& function) const {
+    for (size_t index = 0; index < chunk.ordinals.size(); ++index) {
+        const int ordinal = chunk.ordinals[index];
+        const std::span<const std::string_view> words(chunk.words.data() + chunk.word_offsets[index],
+            chunk.word_offsets[index + 1] - chunk.word_offsets[index]);
+        function(document_ids_[ordinal], words, document_statuses_[ordinal]);
+    }
+}
+
+//общий сегмент слияния и границы исходных сегментов, по которым слияние применяется к другой копии сервера
+struct SearchServer::SegmentMerge {
+    std::vector<int> source_bounds;
+    Segment segment;
 };
 
 void FindTopDocuments(SearchServer const& server, std::string const& query);
@@ -163,28 +647,36 @@ SearchServer::SearchServer(const Container& container)
 
 template < typename DocumentPredicate, class ExecutionPolicy>
 std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, const DocumentPredicate& document_predicate) const {
-    if (!IsValidWord(raw_query)) {
-        throw std::invalid_argument("Query contains invalid characters");
-    }
-    
-    Query query = ParseQuery(raw_query);
+    return FindTopDocuments(policy, raw_query, document_predicate, 0, MAX_RESULT_DOCUMENT_COUNT);
+}
 
-    std::vector<Document> matched_documents = FindAllDocuments(policy, query, document_predicate);
+template < typename DocumentPredicate, class ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, const DocumentPredicate& document_predicate, size_t offset, size_t count) const {
+    //проверка символов запроса совмещена с разбиением его на слова
+    const QueryLease query = ParseQuery(raw_query);
+    return FindTopDocumentsWindow(policy, *query, document_predicate, offset, count);
+}
 
-    sort(policy, matched_documents.begin(), matched_documents.end(),
-        [](const Document& lhs, const Document& rhs) {
-            if (std::abs(lhs.relevance - rhs.relevance) < INACCURACY) {
-                return lhs.rating > rhs.rating;
-            }
-            else {
-                return lhs.relevance > rhs.relevance;
-            }
-        });
+template < typename DocumentPredicate, class ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocumentsWindow(ExecutionPolicy&& policy, const Query& query, const DocumentPredicate& document_predicate, size_t offset, size_t count) const {
+    if (count == 0) {
+        return {};
+    }
 
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+    const size_t top_count = count > std::numeric_limits<size_t>::max() - offset ? std::numeric_limits<size_t>::max() : offset + count;
+    std::vector<Document> matched_documents = FindAllDocuments(policy, query, document_predicate, top_count);
+    if (offset == 0) {
+        return matched_documents;
     }
-    return matched_documents;
+    if (matched_documents.size() <= offset) {
+        return {};
+    }
+    return { matched_documents.begin() + offset, matched_documents.end() };
+}
+
+template < typename DocumentPredicate >
+std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query, const DocumentPredicate& document_predicate, size_t offset, size_t count) const {
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate, offset, count);
 }
 
 template < typename DocumentPredicate >
@@ -195,114 +687,306 @@ std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_
 //FindTopDocuments äëÿ îäíîãî çàïðîñà, â ýòîì ñëó÷àå ñòàòóñ ACTUAL ïî óìîë÷àíèþ
 template< class ExecutionPolicy >
 std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query) const {
-    return FindTopDocuments(policy, raw_query, [](int document_id, DocumentStatus status, int rating) { return status == DocumentStatus::ACTUAL; });
+    return FindTopDocumentsByStatus(policy, raw_query, DocumentStatus::ACTUAL, 0, MAX_RESULT_DOCUMENT_COUNT);
 }
 
 //FindTopDocuments äëÿ çàïðîñà è îïðåäåë¸ííîãî ñòàòóñà
 template< class ExecutionPolicy>
 std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy&& policy, const std::string_view raw_query, DocumentStatus required_status) const {
-    return FindTopDocuments(policy, raw_query, [required_status](int document_id, DocumentStatus status, int rating) { return status == required_status; });
+    return FindTopDocumentsByStatus(policy, raw_query, required_status, 0, MAX_RESULT_DOCUMENT_COUNT);
+}
+
+template< class ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocumentsByStatus(ExecutionPolicy&& policy, const std::string_view raw_query, DocumentStatus required_status, size_t offset, size_t count) const {
+    const QueryLease query = ParseQuery(raw_query);
+    const auto document_predicate = [required_status](int, DocumentStatus status, int) { return status == required_status; };
+    if (!result_cache_) {
+        return FindTopDocumentsWindow(policy, *query, document_predicate, offset, count);
+    }
+    //разобранный запрос уже нормализован: номера термов отсортированы, повторы и стоп-слова отброшены
+    ResultCacheKey key{ query->plus_words, query->minus_words, required_status, offset, count, corpus_generation_ };
+    if (auto documents = result_cache_->Find(key)) {
+        return std::move(*documents);
+    }
+    std::vector<Document> documents = FindTopDocumentsWindow(policy, *query, document_predicate, offset, count);
+    result_cache_->Insert(std::move(key), documents);
+    return documents;
 }
 
 //======== FindAllDocuments ========
 
-template <typename Container, typename It, typename DocumentPredicate>
-void SearchServer::ComputeDocumentRelevance(Container& result_container, It range_begin, It range_end, DocumentPredicate document_predicate) const {
-    for (auto word_it = range_begin; word_it != range_end; word_it = std::next(word_it)) {
-        if (!word_to_document_freqs_.count(*word_it))
+template <typename It, typename DocumentPredicate>
+void SearchServer::ComputeDocumentRelevance(ScoreAccumulator& accumulator, const ScoreAccumulator& exclusions, It range_begin, It range_end,
+    int ordinal_begin, int ordinal_end, DocumentPredicate document_predicate) const {
+    //документ целиком лежит в одном сегменте, поэтому его слова суммируются в том же порядке, что и без сегментов
+    for (const Segment& segment : segments_) {
+        if (segment.ordinal_end <= ordinal_begin || segment.ordinal_begin >= ordinal_end) {
             continue;
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(*word_it);
-        for (const auto [document_id, term_freq] : word_to_document_freqs_.at(*word_it)) {
-            if (document_predicate(document_id, documents_.at(document_id).status, documents_.at(document_id).rating)) {
-                result_container[document_id].ref_to_value += term_freq * inverse_document_freq;
-            }
+        }
+        //удалённые документы отсеиваются вместе с предикатом, один раз на документ
+        PersistentArray<int>::Reader document_ids(document_ids_);
+        PersistentArray<DocumentStatus>::Reader document_statuses(document_statuses_);
+        PersistentArray<int>::Reader document_ratings(document_ratings_);
+        const auto accept_document = [&](int ordinal) {
+            return !segment.IsRemoved(ordinal) && !exclusions.IsExcluded(ordinal)
+                && document_predicate(document_ids[ordinal], document_statuses[ordinal], document_ratings[ordinal]);
+        };
+        for (auto word_it = range_begin; word_it != range_end; word_it = std::next(word_it)) {
+            const PostingList* postings = segment.FindPostingList(*word_it);
+            if (postings == nullptr || term_statistics_[*word_it].document_count == 0)
+                continue;
+            const double inverse_document_freq = ComputeWordInverseDocumentFreq(*word_it);
+            visited_posting_count_ += postings->ForEach(ordinal_begin, ordinal_end, [&](int ordinal, double term_freq) {
+                accumulator.Add(ordinal, term_freq * inverse_document_freq, accept_document);
+                });
         }
     }
 }
 
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const std::execution::sequenced_policy&, const Query& query, DocumentPredicate document_predicate) const {
-    std::map<int, double> document_to_relevance;
-    for (const std::string_view word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
+void SearchServer::CollectTopDocumentsPruned(TopDocuments& top_documents, const ScoreAccumulator& exclusions, const Query& query,
+    int ordinal_begin, int ordinal_end, DocumentPredicate document_predicate) const {
+    //запас на погрешность округления: оценки и суммы окна складываются не в том порядке, что точная релевантность
+    constexpr double BOUND_ROUNDING_MARGIN = 1e-9;
+    const auto scratch = ScratchPool<MaxScoreScratch>::Acquire();
+    std::vector<MaxScoreTerm>& terms = scratch->terms;
+    std::vector<MaxScoreCursor>& cursors = scratch->cursors;
+    std::vector<double>& bound_sums = scratch->bound_sums;
+    std::vector<double>& window_scores = scratch->window_scores;
+    std::vector<uint64_t>& window_documents = scratch->window_documents;
+    std::vector<double>& word_inverse_document_freqs = scratch->word_inverse_document_freqs;
+    uint64_t visited_posting_count = 0;
+
+    word_inverse_document_freqs.assign(query.plus_words.size(), 0.);
+    for (const Segment& segment : segments_) {
+        const int range_begin = std::max(ordinal_begin, segment.ordinal_begin);
+        const int range_end = std::min(ordinal_end, segment.ordinal_end);
+        if (range_begin >= range_end) {
             continue;
         }
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-        for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-            if (document_predicate(document_id, documents_.at(document_id).status, documents_.at(document_id).rating)) {
-                document_to_relevance[document_id] += term_freq * inverse_document_freq;
+        terms.clear();
+        for (size_t word_index = 0; word_index < query.plus_words.size(); ++word_index) {
+            const TermDictionary::TermId term_id = query.plus_words[word_index];
+            const PostingList* postings = segment.FindPostingList(term_id);
+            if (postings == nullptr || term_statistics_[term_id].document_count == 0) {
+                continue;
             }
+            const double inverse_document_freq = ComputeWordInverseDocumentFreq(term_id);
+            word_inverse_document_freqs[word_index] = inverse_document_freq;
+            terms.push_back({ postings, inverse_document_freq, GetMaxTermFreq(term_id) * inverse_document_freq });
+        }
+        std::sort(terms.begin(), terms.end(), [](const MaxScoreTerm& lhs, const MaxScoreTerm& rhs) { return lhs.upper_bound < rhs.upper_bound; });
+        //курсоры листов без записей в диапазоне отбрасываются
+        cursors.resize(terms.size());
+        size_t cursor_count = 0;
+        for (const MaxScoreTerm& term : terms) {
+            MaxScoreCursor& cursor = cursors[cursor_count];
+            cursor.postings.Reset(*term.postings, range_begin);
+            if (cursor.postings.IsEnd() || cursor.postings.GetOrdinal() >= range_end) {
+                visited_posting_count += cursor.postings.GetDecodedCount();
+                continue;
+            }
+            cursor.inverse_document_freq = term.inverse_document_freq;
+            cursor.upper_bound = term.upper_bound;
+            ++cursor_count;
+        }
+        cursors.resize(cursor_count);
+        bound_sums.resize(cursors.size());
+        double bound_sum = 0.;
+        for (size_t index = 0; index < cursors.size(); ++index) {
+            bound_sum += cursors[index].upper_bound;
+            bound_sums[index] = bound_sum;
         }
-    }
 
-    for (const std::string_view word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
+        //курсоры [0, essential_begin) неосновные: даже все вместе они не поднимут документ до порога.
+        //Граница сдвигается только между окнами, чтобы суммы окна не включали слова, которые затем проверяются поиском
+        double threshold = top_documents.GetMinRelevance() - BOUND_ROUNDING_MARGIN;
+        size_t essential_begin = 0;
+        for (int window_begin = range_begin; window_begin < range_end; window_begin += MAX_SCORE_WINDOW) {
+            while (essential_begin < cursors.size() && bound_sums[essential_begin] < threshold) {
+                ++essential_begin;
+            }
+            if (essential_begin == cursors.size()) {
+                break;
+            }
+            const int window_end = std::min(range_end, window_begin + MAX_SCORE_WINDOW);
+            for (size_t index = essential_begin; index < cursors.size(); ++index) {
+                MaxScoreCursor& cursor = cursors[index];
+                for (PostingCursor& postings = cursor.postings; !postings.IsEnd() && postings.GetOrdinal() < window_end; postings.Next()) {
+                    const int ordinal = postings.GetOrdinal();
+                    const int slot = ordinal - window_begin;
+                    uint64_t& documents = window_documents[slot / 64];
+                    const uint64_t bit = uint64_t{ 1 } << (slot % 64);
+                    if ((documents & bit) == 0) {
+                        documents |= bit;
+                        window_scores[slot] = 0.;
+                    }
+                    window_scores[slot] += postings.GetTermFreq() * cursor.inverse_document_freq;
+                }
+            }
+
+            const double non_essential_bound = essential_begin > 0 ? bound_sums[essential_begin - 1] : 0.;
+            for (size_t word = 0; word < window_documents.size(); ++word) {
+                for (uint64_t documents = std::exchange(window_documents[word], 0); documents != 0; documents &= documents - 1) {
+                    const int slot = static_cast<int>(word * 64 + std::countr_zero(documents));
+                    const int ordinal = window_begin + slot;
+                    double score_bound = window_scores[slot] + non_essential_bound;
+                    if (score_bound < threshold || segment.IsRemoved(ordinal) || exclusions.IsExcluded(ordinal)) {
+                        continue;
+                    }
+                    //неосновные листы проверяются от больших оценок к меньшим, пока документ может войти в выдачу
+                    for (size_t index = essential_begin; index-- > 0 && score_bound >= threshold;) {
+                        MaxScoreCursor& cursor = cursors[index];
+                        cursor.postings.Seek(ordinal);
+                        score_bound -= cursor.upper_bound;
+                        if (!cursor.postings.IsEnd() && cursor.postings.GetOrdinal() == ordinal) {
+                            score_bound += cursor.postings.GetTermFreq() * cursor.inverse_document_freq;
+                        }
+                    }
+                    if (score_bound < threshold || !document_predicate(document_ids_[ordinal], document_statuses_[ordinal], document_ratings_[ordinal])) {
+                        continue;
+                    }
+                    top_documents.Add({ document_ids_[ordinal], ComputeExactRelevance(ordinal, query, word_inverse_document_freqs), document_ratings_[ordinal] });
+                    threshold = top_documents.GetMinRelevance() - BOUND_ROUNDING_MARGIN;
+                }
+            }
         }
-        for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-            document_to_relevance.erase(document_id);
+        for (const MaxScoreCursor& cursor : cursors) {
+            visited_posting_count += cursor.postings.GetDecodedCount();
         }
     }
+    visited_posting_count_ += visited_posting_count;
+}
 
-    std::vector<Document> matched_documents;
-    for (const auto [document_id, relevance] : document_to_relevance) {
-        matched_documents.push_back({
-            document_id,
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindAllDocuments(const std::execution::sequenced_policy&, const Query& query, DocumentPredicate document_predicate, size_t top_count) const {
+    auto accumulator = ScoreAccumulator::Acquire(document_ids_.size());
+    ExcludeMinusWords(*accumulator, query);
+    if (scoring_mode_ == ScoringMode::MAX_SCORE) {
+        TopDocuments top_documents(top_count);
+        CollectTopDocumentsPruned(top_documents, *accumulator, query, 0, static_cast<int>(document_ids_.size()), document_predicate);
+        return top_documents.Extract();
+    }
+    ComputeDocumentRelevance(*accumulator, *accumulator, query.plus_words.begin(), query.plus_words.end(),
+        0, static_cast<int>(document_ids_.size()), document_predicate);
+
+    //кандидат, который не попадёт в кучу, отсеивается до чтения id и рейтинга
+    TopDocuments top_documents(top_count);
+    accumulator->ForEachAccepted([&](int ordinal, double relevance) {
+        if (relevance <= top_documents.GetMinRelevance()) {
+            return;
+        }
+        top_documents.Add({
+            document_ids_[ordinal],
             relevance,
-            documents_.at(document_id).rating
+            document_ratings_[ordinal]
             });
-    }
-    return matched_documents;
+        });
+    return top_documents.Extract();
 }
 
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const std::execution::parallel_policy&, const Query& query, DocumentPredicate document_predicate) const {
-    concurrent_map<int, double> document_to_relevance_concurrent(std::thread::hardware_concurrency());
-
-    size_t distance = query.plus_words.size() / std::thread::hardware_concurrency();
-    if (query.plus_words.size() < std::thread::hardware_concurrency())
-        distance = 1u;
-
-    std::vector<std::future<void>> compute_relevance_futures;
-
-    auto range_begin = query.plus_words.begin();
-    auto range_end = query.plus_words.begin();
-
-    while (range_end != query.plus_words.end()) {
-        distance < std::distance(range_end, query.plus_words.end()) ? range_end = std::next(range_end, distance) : range_end = query.plus_words.end();
-        compute_relevance_futures.push_back(std::async([&, range_begin, range_end] {
-            ComputeDocumentRelevance(document_to_relevance_concurrent, range_begin, range_end, document_predicate);
-            }));
-        range_begin = range_end;
-    }
-    for (auto& task : compute_relevance_futures) {
-        task.wait();
-    }
-    std::map<int, double> document_to_relevance = document_to_relevance_concurrent.BuildOrdinaryMap();
-
-    for (const std::string_view word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
+std::vector<Document> SearchServer::FindAllDocuments(const std::execution::parallel_policy&, const Query& query, DocumentPredicate document_predicate, size_t top_count) const {
+    //минус-слова отмечаются в общем аккумуляторе, задачи только читают его до слияния
+    auto accumulator = ScoreAccumulator::Acquire(document_ids_.size());
+    ExcludeMinusWords(*accumulator, query);
+
+    ThreadPool& thread_pool = GetThreadPool();
+    const int ordinal_count = static_cast<int>(document_ids_.size());
+    std::vector<ScoreAccumulator::Lease> part_accumulators;
+
+    //каждая задача считает релевантность в собственный аккумулятор без блокировок. Аккумулятор задачи охватывает
+    //только её диапазон порядковых номеров, поэтому вместе они занимают столько же, сколько один на весь корпус.
+    //Аккумуляторы берутся из пула вызывающего потока, поэтому переиспользуются между запросами
+    if (IsDocumentPartitioningPreferred(query, thread_pool.GetThreadCount())) {
+        //разбиение по документам: задача обходит все слова запроса, но только в своём диапазоне порядковых номеров.
+        //Диапазоны не пересекаются, поэтому суммы совпадают с последовательным поиском бит в бит,
+        //а лучшие документы задача отбирает сама - сливаются только их списки
+        const size_t part_count = GetDocumentPartCount(query, thread_pool.GetThreadCount());
+        const int range_size = static_cast<int>(ordinal_count / part_count + 1);
+        for (size_t part = 0; part < part_count && scoring_mode_ == ScoringMode::EXHAUSTIVE; ++part) {
+            part_accumulators.push_back(ScoreAccumulator::Acquire(range_size, static_cast<int>(part) * range_size));
         }
-        for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-            document_to_relevance.erase(document_id);
+        std::vector<TopDocuments> part_tops(part_count, TopDocuments(top_count));
+        thread_pool.ParallelFor(part_count, [&](size_t part) {
+            const int ordinal_begin = static_cast<int>(part) * range_size;
+            if (scoring_mode_ == ScoringMode::MAX_SCORE) {
+                CollectTopDocumentsPruned(part_tops[part], *accumulator, query,
+                    ordinal_begin, std::min(ordinal_count, ordinal_begin + range_size), document_predicate);
+                return;
+            }
+            ComputeDocumentRelevance(*part_accumulators[part], *accumulator, query.plus_words.begin(), query.plus_words.end(),
+                ordinal_begin, std::min(ordinal_count, ordinal_begin + range_size), document_predicate);
+            part_accumulators[part]->ForEachAccepted([&](int ordinal, double relevance) {
+                if (relevance > part_tops[part].GetMinRelevance()) {
+                    part_tops[part].Add({ document_ids_[ordinal], relevance, document_ratings_[ordinal] });
+                }
+                });
+            });
+        TopDocuments top_documents(top_count);
+        for (const TopDocuments& part_top : part_tops) {
+            top_documents.Merge(part_top);
         }
+        return top_documents.Extract();
     }
 
-    std::vector<Document> matched_documents;
-    for (const auto [document_id, relevance] : document_to_relevance) {
-        matched_documents.push_back({
-            document_id,
-            relevance,
-            documents_.at(document_id).rating
+    //разбиение по словам: задача распаковывает постинг-листы своей части плюс-слов целиком и сохраняет вклад
+    //каждого слова отдельным списком. Затем вклады суммируются по диапазонам документов в порядке слов запроса,
+    //как при последовательном поиске, поэтому суммы совпадают с ним бит в бит
+    const size_t word_count = query.plus_words.size();
+    const auto word_scores = ScratchPool<WordScoresScratch>::Acquire();
+    if (word_scores->words.size() < word_count) {
+        word_scores->words.resize(word_count);
+    }
+    const size_t word_part_count = std::max<size_t>(1u, std::min<size_t>(thread_pool.GetThreadCount(), word_count));
+    const size_t word_part_size = word_count / word_part_count + 1;
+    thread_pool.ParallelFor(word_part_count, [&](size_t part) {
+        for (size_t word_index = part * word_part_size; word_index < std::min(word_count, (part + 1) * word_part_size); ++word_index) {
+            CollectWordScores(query.plus_words[word_index], *accumulator, word_scores->words[word_index]);
+        }
+        });
+
+    const size_t part_count = std::max<size_t>(1u, thread_pool.GetThreadCount());
+    const int range_size = static_cast<int>(ordinal_count / part_count + 1);
+    for (size_t part = 0; part < part_count; ++part) {
+        part_accumulators.push_back(ScoreAccumulator::Acquire(range_size, static_cast<int>(part) * range_size));
+    }
+    std::vector<TopDocuments> part_tops(part_count, TopDocuments(top_count));
+    thread_pool.ParallelFor(part_count, [&](size_t part) {
+        const int ordinal_begin = static_cast<int>(part) * range_size;
+        const int ordinal_end = std::min(ordinal_count, ordinal_begin + range_size);
+        PersistentArray<int>::Reader document_ids(document_ids_);
+        PersistentArray<DocumentStatus>::Reader document_statuses(document_statuses_);
+        PersistentArray<int>::Reader document_ratings(document_ratings_);
+        const auto accept_document = [&](int ordinal) {
+            return document_predicate(document_ids[ordinal], document_statuses[ordinal], document_ratings[ordinal]);
+        };
+        ScoreAccumulator& part_accumulator = *part_accumulators[part];
+        for (size_t word_index = 0; word_index < word_count; ++word_index) {
+            const std::vector<std::pair<int, double>>& scores = word_scores->words[word_index];
+            auto score_it = std::lower_bound(scores.begin(), scores.end(), ordinal_begin, [](const std::pair<int, double>& score, int ordinal) {
+                return score.first < ordinal;
+                });
+            for (; score_it != scores.end() && score_it->first < ordinal_end; ++score_it) {
+                part_accumulator.Add(score_it->first, score_it->second, accept_document);
+            }
+        }
+        part_accumulator.ForEachAccepted([&](int ordinal, double relevance) {
+            if (relevance > part_tops[part].GetMinRelevance()) {
+                part_tops[part].Add({ document_ids_[ordinal], relevance, document_ratings_[ordinal] });
+            }
             });
+        });
+    TopDocuments top_documents(top_count);
+    for (const TopDocuments& part_top : part_tops) {
+        top_documents.Merge(part_top);
     }
-    return matched_documents;
+    return top_documents.Extract();
 }
 
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentPredicate document_predicate) const {
-    return FindAllDocuments(std::execution::seq, query, document_predicate);
+std::vector<Document> SearchServer::FindAllDocuments(const Query& query, DocumentPredicate document_predicate, size_t top_count) const {
+    return FindAllDocuments(std::execution::seq, query, document_predicate, top_count);
 }
 
 //================
@@ -0,0 +1,265 @@
+#include "snapshot.h"
+
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char SNAPSHOT_MAGIC[8] = { 'S', 'S', 'R', 'V', 'S', 'N', 'A', 'P' };
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+constexpr size_t SECTION_COUNT = static_cast<size_t>(SnapshotSection::COUNT);
+constexpr size_t SECTION_ALIGNMENT = 8;
+
+struct SnapshotHeader {
+    struct Entry {
+        uint64_t offset;
+        uint64_t size;
+        uint64_t checksum;
+    };
+
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t section_count;
+    uint32_t reserved;
+    Entry sections[SECTION_COUNT];
+    //     
+    uint64_t header_checksum;
+};
+
+static_assert(sizeof(SnapshotHeader) % SECTION_ALIGNMENT == 0);
+
+uint64_t ComputeChecksum(const char* data, size_t size) {
+    SnapshotChecksum checksum;
+    checksum.Update(data, size);
+    return checksum.Finish();
+}
+
+uint64_t ComputeHeaderChecksum(const SnapshotHeader& header) {
+    return ComputeChecksum(reinterpret_cast<const char*>(&header), offsetof(SnapshotHeader, header_checksum));
+}
+
+} // namespace
+
+//======== SnapshotChecksum ========
+
+void SnapshotChecksum::Update(const char* data, size_t size) {
+    while (size > 0 && pending_size_ > 0) {
+        pending_ |= static_cast<uint64_t>(static_cast<unsigned char>(*data)) << (pending_size_ * 8);
+        ++data;
+        --size;
+        if (++pending_size_ == sizeof(uint64_t)) {
+            UpdateWord(pending_);
+            pending_ = 0;
+            pending_size_ = 0;
+        }
+    }
+    for (; size >= sizeof(uint64_t); data += sizeof(uint64_t), size -= sizeof(uint64_t)) {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        UpdateWord(word);
+    }
+    for (; size > 0; ++data, --size) {
+        pending_ |= static_cast<uint64_t>(static_cast<unsigned char>(*data)) << (pending_size_ * 8);
+        ++pending_size_;
+    }
+}
+
+uint64_t SnapshotChecksum::Finish() {
+    if (pending_size_ > 0) {
+        UpdateWord(pending_);
+        pending_ = 0;
+        pending_size_ = 0;
+    }
+    return hash_;
+}
+
+void SnapshotChecksum::UpdateWord(uint64_t word) {
+    hash_ = (hash_ ^ word) * 0xBF58476D1CE4E5B9ull;
+    hash_ ^= hash_ >> 31;
+}
+
+//======== MappedFile ========
+
+#ifdef _WIN32
+MappedFile::MappedFile(const std::string& path) {
+    file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        file_ = nullptr;
+        throw std::runtime_error("Cannot open snapshot file " + path);
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file_, &size)) {
+        CloseHandle(file_);
+        throw std::runtime_error("Cannot read snapshot file " + path);
+    }
+    size_ = static_cast<size_t>(size.QuadPart);
+    if (size_ == 0) {
+        return;
+    }
+    mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_ != nullptr) {
+        data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    }
+    if (data_ == nullptr) {
+        if (mapping_ != nullptr) {
+            CloseHandle(mapping_);
+        }
+        CloseHandle(file_);
+        throw std::runtime_error("Cannot map snapshot file " + path);
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_ != nullptr) {
+        CloseHandle(mapping_);
+    }
+    if (file_ != nullptr) {
+        CloseHandle(file_);
+    }
+}
+#else
+MappedFile::MappedFile(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Cannot open snapshot file " + path);
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0) {
+        close(fd);
+        throw std::runtime_error("Cannot read snapshot file " + path);
+    }
+    size_ = static_cast<size_t>(file_stat.st_size);
+    if (size_ > 0) {
+        void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("Cannot map snapshot file " + path);
+        }
+        data_ = static_cast<const char*>(data);
+    }
+    //      
+    close(fd);
+}
+
+MappedFile::~MappedFile() {
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+}
+#endif
+
+//======== SnapshotWriter ========
+
+//        Finish,       
+SnapshotWriter::SnapshotWriter(const std::string& path)
+    : path_(path)
+    , output_(path + ".tmp", std::ios::binary | std::ios::trunc)
+    , sections_(SECTION_COUNT)
+{
+    if (!output_) {
+        throw std::runtime_error("Cannot create snapshot file " + path);
+    }
+    const SnapshotHeader header{};
+    output_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    position_ = sizeof(header);
+}
+
+void SnapshotWriter::BeginSection(SnapshotSection section) {
+    current_section_ = section;
+    current_checksum_ = SnapshotChecksum();
+    sections_[static_cast<size_t>(section)].offset = position_;
+}
+
+void SnapshotWriter::Append(const void* data, size_t size) {
+    output_.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    current_checksum_.Update(static_cast<const char*>(data), size);
+    position_ += size;
+}
+
+void SnapshotWriter::EndSection() {
+    SectionEntry& entry = sections_[static_cast<size_t>(current_section_)];
+    entry.size = position_ - entry.offset;
+    entry.checksum = current_checksum_.Finish();
+    const char padding[SECTION_ALIGNMENT] = {};
+    const size_t padding_size = (SECTION_ALIGNMENT - position_ % SECTION_ALIGNMENT) % SECTION_ALIGNMENT;
+    output_.write(padding, static_cast<std::streamsize>(padding_size));
+    position_ += padding_size;
+    current_section_ = SnapshotSection::COUNT;
+}
+
+void SnapshotWriter::Finish() {
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.section_count = static_cast<uint32_t>(SECTION_COUNT);
+    for (size_t section = 0; section < SECTION_COUNT; ++section) {
+        header.sections[section] = { sections_[section].offset, sections_[section].size, sections_[section].checksum };
+    }
+    header.header_checksum = ComputeHeaderChecksum(header);
+    output_.seekp(0);
+    output_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    output_.close();
+    if (!output_) {
+        throw std::runtime_error("Cannot write snapshot file " + path_);
+    }
+    std::error_code error;
+    std::filesystem::rename(path_ + ".tmp", path_, error);
+    if (error) {
+        throw std::runtime_error("Cannot write snapshot file " + path_);
+    }
+}
+
+//======== SnapshotReader ========
+
+SnapshotReader::SnapshotReader(const MappedFile& file, SnapshotVerification verification) {
+    SnapshotHeader header;
+    if (file.GetSize() < sizeof(header)) {
+        throw std::runtime_error("Snapshot file is truncated");
+    }
+    std::memcpy(&header, file.GetData(), sizeof(header));
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0) {
+        throw std::runtime_error("File is not a search server snapshot");
+    }
+    if (header.byte_order != BYTE_ORDER_MARK) {
+        throw std::runtime_error("Snapshot was written on a machine with another byte order");
+    }
+    if (header.version != SNAPSHOT_VERSION || header.section_count != SECTION_COUNT) {
+        throw std::runtime_error("Unsupported snapshot version");
+    }
+    if (header.header_checksum != ComputeHeaderChecksum(header)) {
+        throw std::runtime_error("Snapshot header is corrupted");
+    }
+    for (size_t section = 0; section < SECTION_COUNT; ++section) {
+        const SnapshotHeader::Entry& entry = header.sections[section];
+        if (entry.offset % SECTION_ALIGNMENT != 0 || entry.offset > file.GetSize() || entry.size > file.GetSize() - entry.offset) {
+            throw std::runtime_error("Snapshot file is truncated");
+        }
+        const std::string_view bytes(file.GetData() + entry.offset, static_cast<size_t>(entry.size));
+        const bool is_record_section = section == static_cast<size_t>(SnapshotSection::POSTING_DATA)
+            || section == static_cast<size_t>(SnapshotSection::DOCUMENT_TERMS);
+        const bool is_verified = verification == SnapshotVerification::FULL || !is_record_section;
+        if (is_verified && ComputeChecksum(bytes.data(), bytes.size()) != entry.checksum) {
+            throw std::runtime_error("Snapshot checksum mismatch");
+        }
+        sections_.push_back(bytes);
+    }
+}
+
+std::string_view SnapshotReader::GetBytes(SnapshotSection section) const {
+    return sections_[static_cast<size_t>(section)];
+}
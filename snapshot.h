@@ -0,0 +1,132 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//  :    ,  ,    8 .
+// -  ,         .
+//     ,  ;      
+enum class SnapshotSection : uint32_t {
+    STOP_WORD_STRINGS,
+    STOP_WORD_OFFSETS,
+    TERM_STRINGS,
+    TERM_OFFSETS,
+    TERM_HASH_SLOTS,
+    POSTING_OFFSETS,
+    POSTING_BLOCKS,
+    POSTING_DATA_OFFSETS,
+    POSTING_DATA,
+    DOCUMENT_TERM_OFFSETS,
+    DOCUMENT_TERMS,
+    DOCUMENT_IDS,
+    DOCUMENT_STATUSES,
+    DOCUMENT_RATINGS,
+    COUNT,
+};
+
+constexpr uint32_t SNAPSHOT_VERSION = 2;
+
+//    . STRUCTURE     ,   
+//   :       ,       
+enum class SnapshotVerification {
+    FULL,
+    STRUCTURE,
+};
+
+//   8- ;     
+class SnapshotChecksum {
+public:
+    void Update(const char* data, size_t size);
+    uint64_t Finish();
+
+private:
+    uint64_t hash_ = 0x9E3779B97F4A7C15ull;
+    uint64_t pending_ = 0;
+    size_t pending_size_ = 0;
+
+    void UpdateWord(uint64_t word);
+};
+
+//,      
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    const char* GetData() const {
+        return data_;
+    }
+
+    size_t GetSize() const {
+        return size_;
+    }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#endif
+};
+
+//  ;         Finish
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(const std::string& path);
+
+    void BeginSection(SnapshotSection section);
+    void Append(const void* data, size_t size);
+    void EndSection();
+
+    template <typename T>
+    void AddSection(SnapshotSection section, const std::vector<T>& values) {
+        BeginSection(section);
+        Append(values.data(), values.size() * sizeof(T));
+        EndSection();
+    }
+
+    void Finish();
+
+private:
+    struct SectionEntry {
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        uint64_t checksum = 0;
+    };
+
+    std::string path_;
+    std::ofstream output_;
+    std::vector<SectionEntry> sections_;
+    SnapshotSection current_section_ = SnapshotSection::COUNT;
+    SnapshotChecksum current_checksum_;
+    uint64_t position_ = 0;
+};
+
+//           .
+// ,     - std::runtime_error
+class SnapshotReader {
+public:
+    SnapshotReader(const MappedFile& file, SnapshotVerification verification);
+
+    std::string_view GetBytes(SnapshotSection section) const;
+
+    template <typename T>
+    std::span<const T> GetArray(SnapshotSection section) const {
+        const std::string_view bytes = GetBytes(section);
+        if (bytes.size() % sizeof(T) != 0) {
+            throw std::runtime_error("Snapshot section has wrong size");
+        }
+        return { reinterpret_cast<const T*>(bytes.data()), bytes.size() / sizeof(T) };
+    }
+
+private:
+    std::vector<std::string_view> sections_;
+};
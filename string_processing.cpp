@@ -1,18 +1,132 @@
 #include "string_processing.h"
-#include <iostream>
 #include <algorithm>
+#include <bit>
+#include <cstdint>
 
-//   string  ,    
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SEARCH_SERVER_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SEARCH_SERVER_SSE2
+#endif
+
+namespace {
+
+constexpr size_t BLOCK_SIZE = 64;
+
+//   :  i ,   i -    
+struct BlockMasks {
+    uint64_t spaces = 0;
+    uint64_t controls = 0;
+};
+
+BlockMasks ScanBlockScalar(const char* data, size_t size) {
+    BlockMasks masks;
+    for (size_t i = 0; i < size; ++i) {
+        const unsigned char c = static_cast<unsigned char>(data[i]);
+        masks.spaces |= static_cast<uint64_t>(c == ' ') << i;
+        masks.controls |= static_cast<uint64_t>(c < ' ') << i;
+    }
+    return masks;
+}
 
+#if defined(SEARCH_SERVER_AVX2)
+BlockMasks ScanFullBlock(const char* data) {
+    const __m256i space = _mm256_set1_epi8(' ');
+    const __m256i last_control = _mm256_set1_epi8(' ' - 1);
+    BlockMasks masks;
+    for (size_t part = 0; part < BLOCK_SIZE / 32; ++part) {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + part * 32));
+        //   31  ,  min(, 31)    
+        const __m256i is_control = _mm256_cmpeq_epi8(_mm256_min_epu8(bytes, last_control), bytes);
+        masks.spaces |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(bytes, space)))) << (part * 32);
+        masks.controls |= static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(is_control))) << (part * 32);
+    }
+    return masks;
+}
+#elif defined(SEARCH_SERVER_SSE2)
+BlockMasks ScanFullBlock(const char* data) {
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i last_control = _mm_set1_epi8(' ' - 1);
+    BlockMasks masks;
+    for (size_t part = 0; part < BLOCK_SIZE / 16; ++part) {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + part * 16));
+        //   31  ,  min(, 31)    
+        const __m128i is_control = _mm_cmpeq_epi8(_mm_min_epu8(bytes, last_control), bytes);
+        masks.spaces |= static_cast<uint64_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, space))) << (part * 16);
+        masks.controls |= static_cast<uint64_t>(_mm_movemask_epi8(is_control)) << (part * 16);
+    }
+    return masks;
+}
+#else
+BlockMasks ScanFullBlock(const char* data) {
+    return ScanBlockScalar(data, BLOCK_SIZE);
+}
+#endif
+
+//  ; on_block   ,        ,  false
+template <typename BlockHandler>
+bool ScanBlocks(const std::string_view text, BlockHandler&& on_block) {
+    size_t offset = 0;
+    for (; offset + BLOCK_SIZE <= text.size(); offset += BLOCK_SIZE) {
+        if (!on_block(offset, BLOCK_SIZE, ScanFullBlock(text.data() + offset))) {
+            return false;
+        }
+    }
+    if (offset < text.size()) {
+        const size_t size = text.size() - offset;
+        return on_block(offset, size, ScanBlockScalar(text.data() + offset, size));
+    }
+    return true;
+}
+
+//  -     ;    i ,   i-1  i  
+bool SplitBlocks(const std::string_view text, std::vector<std::string_view>& words, bool validate) {
+    words.clear();
+    size_t word_begin = 0;
+    bool in_word = false;
+    const bool is_valid = ScanBlocks(text, [&](size_t offset, size_t size, const BlockMasks& masks) {
+        if (validate && masks.controls != 0) {
+            return false;
+        }
+        const uint64_t block_bits = size == BLOCK_SIZE ? ~uint64_t{ 0 } : (uint64_t{ 1 } << size) - 1;
+        const uint64_t word_bytes = ~masks.spaces & block_bits;
+        uint64_t transitions = (word_bytes ^ ((word_bytes << 1) | static_cast<uint64_t>(in_word))) & block_bits;
+        while (transitions != 0) {
+            const size_t position = offset + std::countr_zero(transitions);
+            if (in_word) {
+                words.push_back(text.substr(word_begin, position - word_begin));
+            }
+            else {
+                word_begin = position;
+            }
+            in_word = !in_word;
+            transitions &= transitions - 1;
+        }
+        return true;
+        });
+    if (is_valid && in_word) {
+        words.push_back(text.substr(word_begin));
+    }
+    return is_valid;
+}
+
+} // namespace
+
+//   string  ,    
 std::vector<std::string_view> SplitIntoWords(std::string_view text) {
     std::vector<std::string_view> result;
-    text.remove_prefix(std::min(text.find_first_not_of(" "), text.size())); //   
-    while (!text.empty()) {
-        size_t position_first_space = text.find(' ');
-        std::string_view tmp_substr = text.substr(0, position_first_space);
-        result.push_back(tmp_substr);
-        text.remove_prefix(tmp_substr.size());
-        text.remove_prefix(std::min(text.find_first_not_of(" "), text.size())); //   
-    }
+    SplitBlocks(text, result, false);
     return result;
-}
\ No newline at end of file
+}
+
+bool SplitIntoValidWords(const std::string_view text, std::vector<std::string_view>& words) {
+    return SplitBlocks(text, words, true);
+}
+
+bool ContainsControlCharacters(const std::string_view text) {
+    return !ScanBlocks(text, [](size_t, size_t, const BlockMasks& masks) {
+        return masks.controls == 0;
+        });
+}
@@ -3,4 +3,12 @@
 #include<string_view>
 
 //   string  ,    
-std::vector<std::string_view> SplitIntoWords(const std::string_view text);
\ No newline at end of file
+std::vector<std::string_view> SplitIntoWords(const std::string_view text);
+
+//      ,       ( 0-31).
+//   words (  ),     false.
+//    16-32   SSE2/AVX2,   
+bool SplitIntoValidWords(const std::string_view text, std::vector<std::string_view>& words);
+
+//      ( 0-31)
+bool ContainsControlCharacters(const std::string_view text);
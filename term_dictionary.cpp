@@ -0,0 +1,129 @@
+#include "term_dictionary.h"
+
+#include <algorithm>
+#include <bit>
+
+TermDictionary::TermDictionary(const MappedTerms& mapped_terms)
+    : mapped_terms_(mapped_terms)
+{
+}
+
+//   ,       O(1)  
+TermDictionary::TermId TermDictionary::Intern(std::string_view term) {
+    const TermId found = Find(term);
+    if (found != NO_TERM) {
+        return found;
+    }
+    const TermId term_id = static_cast<TermId>(GetTermCount());
+    terms_.push_back(Store(term));
+    if (slots_.size() < terms_.size() * 2) {
+        RebuildSlots(std::max<size_t>(16, std::bit_ceil(terms_.size() * 4)));
+        return term_id;
+    }
+    const size_t mask = slots_.size() - 1;
+    size_t slot = Hash(term) & mask;
+    while (slots_[slot].term_id != NO_TERM) {
+        slot = (slot + 1) & mask;
+    }
+    slots_.Mutable(slot) = { terms_[terms_.size() - 1], term_id };
+    return term_id;
+}
+
+TermDictionary::TermId TermDictionary::Find(std::string_view term) const {
+    const TermId mapped = FindMapped(term);
+    if (mapped != NO_TERM) {
+        return mapped;
+    }
+    return FindStored(term);
+}
+
+std::string_view TermDictionary::GetTerm(TermId term_id) const {
+    if (term_id < mapped_terms_.term_count) {
+        const uint64_t begin = mapped_terms_.offsets[term_id];
+        return { mapped_terms_.strings + begin, static_cast<size_t>(mapped_terms_.offsets[term_id + 1] - begin) };
+    }
+    return terms_[term_id - mapped_terms_.term_count];
+}
+
+size_t TermDictionary::GetTermCount() const {
+    return mapped_terms_.term_count + terms_.size();
+}
+
+//     ,          
+std::vector<TermDictionary::TermId> TermDictionary::BuildHashSlots() const {
+    size_t slot_count = 2;
+    while (slot_count < GetTermCount() * 2) {
+        slot_count *= 2;
+    }
+    std::vector<TermId> slots(slot_count, NO_TERM);
+    for (TermId term_id = 0; term_id < GetTermCount(); ++term_id) {
+        size_t slot = Hash(GetTerm(term_id)) & (slot_count - 1);
+        while (slots[slot] != NO_TERM) {
+            slot = (slot + 1) & (slot_count - 1);
+        }
+        slots[slot] = term_id;
+    }
+    return slots;
+}
+
+//FNV-1a
+uint64_t TermDictionary::Hash(std::string_view term) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const char c : term) {
+        hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+//     ;        
+std::string_view TermDictionary::Store(std::string_view term) {
+    std::lock_guard guard(arena_->mutex);
+    std::vector<std::unique_ptr<char[]>>& blocks = arena_->blocks;
+    size_t& block_used = arena_->block_used;
+    if (blocks.empty() || term.size() > BLOCK_SIZE - block_used) {
+        blocks.push_back(std::make_unique<char[]>(std::max(BLOCK_SIZE, term.size())));
+        block_used = 0;
+    }
+    char* data = blocks.back().get() + block_used;
+    std::copy(term.begin(), term.end(), data);
+    block_used = std::min(BLOCK_SIZE, block_used + term.size());
+    return { data, term.size() };
+}
+
+TermDictionary::TermId TermDictionary::FindMapped(std::string_view term) const {
+    if (mapped_terms_.slot_count == 0) {
+        return NO_TERM;
+    }
+    const size_t mask = mapped_terms_.slot_count - 1;
+    for (size_t slot = Hash(term) & mask;; slot = (slot + 1) & mask) {
+        const TermId term_id = mapped_terms_.slots[slot];
+        if (term_id == NO_TERM || GetTerm(term_id) == term) {
+            return term_id;
+        }
+    }
+}
+
+TermDictionary::TermId TermDictionary::FindStored(std::string_view term) const {
+    if (slots_.empty()) {
+        return NO_TERM;
+    }
+    const size_t mask = slots_.size() - 1;
+    for (size_t slot = Hash(term) & mask;; slot = (slot + 1) & mask) {
+        const Slot& stored = slots_[slot];
+        if (stored.term_id == NO_TERM || stored.term == term) {
+            return stored.term_id;
+        }
+    }
+}
+
+void TermDictionary::RebuildSlots(size_t slot_count) {
+    std::vector<Slot> slots(slot_count);
+    for (size_t index = 0; index < terms_.size(); ++index) {
+        size_t slot = Hash(terms_[index]) & (slot_count - 1);
+        while (slots[slot].term_id != NO_TERM) {
+            slot = (slot + 1) & (slot_count - 1);
+        }
+        slots[slot] = { terms_[index], static_cast<TermId>(mapped_terms_.term_count + index) };
+    }
+    slots_ = PersistentArray<Slot>(std::move(slots));
+}
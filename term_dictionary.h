@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <vector>
+
+#include "persistent_array.h"
+
+// :            32- .
+//      ,     ,
+// string_view,   GetTerm,     .
+//      :      ,    -
+//  PersistentArray,             
+class TermDictionary {
+public:
+    using TermId = uint32_t;
+    static constexpr TermId NO_TERM = std::numeric_limits<TermId>::max();
+
+    //      ( ):   ,  
+    // -    .     ,     
+    struct MappedTerms {
+        const char* strings = nullptr;
+        //term_count + 1   strings
+        const uint64_t* offsets = nullptr;
+        //slot_count  ( ),   - NO_TERM
+        const TermId* slots = nullptr;
+        size_t term_count = 0;
+        size_t slot_count = 0;
+    };
+
+    TermDictionary() = default;
+    //   ;       
+    explicit TermDictionary(const MappedTerms& mapped_terms);
+
+    // ,     
+    TermId Intern(std::string_view term);
+    //   NO_TERM,      
+    TermId Find(std::string_view term) const;
+
+    std::string_view GetTerm(TermId term_id) const;
+    size_t GetTermCount() const;
+
+    //-     MappedTerms::slots
+    std::vector<TermId> BuildHashSlots() const;
+
+    // ,        
+    static uint64_t Hash(std::string_view term);
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;
+
+    // ,      .      ,
+    //    ;      ,      terms_
+    struct Arena {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<char[]>> blocks;
+        size_t block_used = BLOCK_SIZE;
+    };
+
+    MappedTerms mapped_terms_;
+    std::shared_ptr<Arena> arena_ = std::make_shared<Arena>();
+    // ,     mapped_terms_.term_count;   -    
+    PersistentArray<std::string_view> terms_;
+    //      ,      terms_
+    struct Slot {
+        std::string_view term;
+        TermId term_id = NO_TERM;
+    };
+
+    //-     ;      
+    PersistentArray<Slot> slots_;
+
+    std::string_view Store(std::string_view term);
+    TermId FindMapped(std::string_view term) const;
+    TermId FindStored(std::string_view term) const;
+    void RebuildSlots(size_t slot_count);
+};
@@ -3,6 +3,12 @@
 #include <set>
 #include <list>
 #include <execution>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <numeric>
 
 #include "tests.h"
 #include "search_server.h"
@@ -10,6 +16,16 @@
 #include "assert.h"
 #include "remove_duplicates.h"
 #include "process_queries.h"
+#include "top_documents.h"
+#include "score_accumulator.h"
+#include "paginator.h"
+#include "thread_pool.h"
+#include "posting_list.h"
+#include "term_dictionary.h"
+#include "persistent_array.h"
+#include "ordinal_map.h"
+#include "string_processing.h"
+#include "concurrent_search_server.h"
 
 using namespace std;
 
@@ -202,6 +218,105 @@ void TestParallelMatchingDocument() {
     }
 }
 
+void TestMatchDocuments() {
+    //     ,    id    
+    const vector<string> words = { "cat"s, "dog"s, "tail"s, "collar"s, "bird"s, "eyes"s };
+    SearchServer search_server;
+    const int document_count = 40000;
+    for (int i = 0; i < document_count; ++i) {
+        string text;
+        for (size_t word = 0; word < words.size(); ++word) {
+            if ((i >> word) % 3 == 0) {
+                text += words[word] + " "s;
+            }
+        }
+        search_server.AddDocument((i * 7919) % document_count, text + "x"s, i % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, { 1 });
+    }
+    for (int id = 0; id < document_count; id += 11) {
+        search_server.RemoveDocument(id);
+    }
+
+    const string query = "tail dog eyes cat -collar"s;
+    const auto all_matches = search_server.MatchDocuments(query);
+    ASSERT_EQUAL(all_matches.size(), search_server.GetDocumentCount());
+    size_t matched_count = 0;
+    int previous_id = -1;
+    for (const auto& [id, matched_words, status] : all_matches) {
+        ASSERT(id > previous_id);
+        previous_id = id;
+        const auto [expected_words, expected_status] = search_server.MatchDocument(query, id);
+        ASSERT(matched_words == expected_words);
+        ASSERT(status == expected_status);
+        matched_count += matched_words.empty() ? 0 : 1;
+    }
+    ASSERT(matched_count > 0u);
+
+    //         
+    const auto collect = [&](const auto& policy) {
+        vector<tuple<int, vector<string_view>, DocumentStatus>> matches;
+        search_server.MatchDocuments(policy, query, [&](int id, span<const string_view> matched_words, DocumentStatus status) {
+            matches.push_back({ id, { matched_words.begin(), matched_words.end() }, status });
+            });
+        return matches;
+    };
+    const auto sequential_matches = collect(execution::seq);
+    ASSERT_EQUAL(sequential_matches.size(), matched_count);
+    ASSERT(sequential_matches == collect(execution::par));
+    auto id_it = search_server.begin();
+    for (const auto& [id, matched_words, status] : sequential_matches) {
+        while (id_it != search_server.end() && *id_it != id) {
+            ++id_it;
+        }
+        ASSERT(id_it != search_server.end());
+        ASSERT(!matched_words.empty());
+        ASSERT(matched_words == get<0>(search_server.MatchDocument(query, id)));
+    }
+
+    SearchServer empty_server;
+    ASSERT(empty_server.MatchDocuments("cat"s).empty());
+}
+
+void TestMatchDocumentTermIntersection() {
+    //  :     ,     
+    SearchServer search_server;
+    string text;
+    for (int i = 0; i < 500; i += 2) {
+        text += "w"s + to_string(i) + " "s;
+    }
+    search_server.AddDocument(1, text, DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(2, "w1 w3"s, DocumentStatus::BANNED, { 1 });
+
+    for (const string& query : { "w0"s, "w498 w1 w250"s, "w499 w3"s }) {
+        for (const int id : { 1, 2 }) {
+            const auto [words, status] = search_server.MatchDocument(query, id);
+            const auto [parallel_words, parallel_status] = search_server.MatchDocument(execution::par, query, id);
+            vector<string_view> expected;
+            for (const string_view word : SplitIntoWords(query)) {
+                const auto frequencies = search_server.GetWordFrequencies(id);
+                if (frequencies.count(word) > 0) {
+                    expected.push_back(word);
+                }
+            }
+            sort(expected.begin(), expected.end());
+            ASSERT(words == expected);
+            ASSERT(parallel_words == expected);
+            ASSERT(status == parallel_status);
+        }
+    }
+
+    string long_query;
+    for (int i = 0; i < 500; i += 3) {
+        long_query += "w"s + to_string(i) + " "s;
+    }
+    const auto [words, status] = search_server.MatchDocument(long_query, 1);
+    ASSERT_EQUAL(words.size(), 84u);
+    ASSERT(is_sorted(words.begin(), words.end()));
+    ASSERT(search_server.MatchDocument(execution::par, long_query, 1) == search_server.MatchDocument(long_query, 1));
+    ASSERT(get<0>(search_server.MatchDocument(long_query + "-w498"s, 1)).empty());
+    ASSERT(get<0>(search_server.MatchDocument(execution::par, "w0 -w496"s, 1)).empty());
+    ASSERT_EQUAL(get<0>(search_server.MatchDocument("w0 -w497"s, 1)).size(), 1u);
+}
+
 void TestSortByRelevance() {
     const int doc_id_1 = 1;
     const string content_1 = "cat in the city London"s;
@@ -434,6 +549,160 @@ void TestRequestQueue() {
     ASSERT_EQUAL(request_queue.GetNoResultRequests(), 1437u);
 }
 
+void TestRequestStatistics() {
+    using namespace std::chrono;
+    //   :        
+    {
+        RequestStatistics statistics(4);
+        statistics.Record(0, microseconds(1));
+        statistics.Record(3, microseconds(5));
+        statistics.Record(0, microseconds(100));
+        ASSERT_EQUAL(statistics.GetNoResultRequests(), 2);
+        statistics.Record(40, milliseconds(3));
+        statistics.Record(1, microseconds(3));
+        const QueryStatistics result = statistics.Get();
+        ASSERT_EQUAL(result.request_count, 4);
+        ASSERT_EQUAL(result.no_result_count, 1);
+        ASSERT_EQUAL(result.hit_histogram[0], 1);
+        ASSERT_EQUAL(result.hit_histogram[1], 1);
+        ASSERT_EQUAL(result.hit_histogram[3], 1);
+        ASSERT_EQUAL(result.hit_histogram[HIT_BUCKET_COUNT - 1], 1);
+        ASSERT_EQUAL(result.latency_histogram[0], 0);
+        ASSERT_EQUAL(result.latency_histogram[1], 1);
+        ASSERT_EQUAL(result.latency_histogram[2], 1);
+        ASSERT_EQUAL(result.latency_histogram[6], 1);
+        ASSERT_EQUAL(result.latency_histogram[11], 1);
+        ASSERT(result.GetLatencyPercentile(0.5) == microseconds(8));
+        ASSERT(result.GetLatencyPercentile(1.) == microseconds(4096));
+    }
+    //   :       ,    
+    {
+        RequestStatistics statistics(2, StatisticsWindow::MINUTES);
+        const RequestStatistics::Clock::time_point start{ hours(1) };
+        statistics.Record(0, microseconds(10), start);
+        statistics.Record(2, microseconds(10), start + seconds(30));
+        statistics.Record(0, microseconds(10), start + minutes(1));
+        ASSERT_EQUAL(statistics.Get(start + minutes(1)).request_count, 3);
+        ASSERT_EQUAL(statistics.GetNoResultRequests(start + minutes(1)), 2);
+        ASSERT_EQUAL(statistics.Get(start + minutes(2)).request_count, 1);
+        ASSERT_EQUAL(statistics.Get(start + minutes(3)).request_count, 0);
+        statistics.Record(1, microseconds(10), start + minutes(2));
+        //      
+        statistics.Record(0, microseconds(10), start);
+        const QueryStatistics result = statistics.Get(start + minutes(2));
+        ASSERT_EQUAL(result.request_count, 2);
+        ASSERT_EQUAL(result.no_result_count, 1);
+        ASSERT_EQUAL(result.hit_histogram[1], 1);
+    }
+    //       
+    {
+        SearchServer search_server("and"s);
+        search_server.AddDocument(1, "curly cat curly tail"s, DocumentStatus::ACTUAL, { 7 });
+        search_server.AddDocument(2, "curly dog and fancy collar"s, DocumentStatus::ACTUAL, { 1 });
+        RequestQueue request_queue(search_server, 10000);
+        vector<thread> threads;
+        for (int thread_index = 0; thread_index < 4; ++thread_index) {
+            threads.emplace_back([&request_queue] {
+                for (int i = 0; i < 500; ++i) {
+                    request_queue.AddFindRequest(i % 2 == 0 ? "curly"s : "parrot"s);
+                }
+                });
+        }
+        for (thread& worker : threads) {
+            worker.join();
+        }
+        const QueryStatistics result = request_queue.GetStatistics();
+        ASSERT_EQUAL(result.request_count, 2000);
+        ASSERT_EQUAL(request_queue.GetNoResultRequests(), 1000);
+        ASSERT_EQUAL(result.hit_histogram[2], 1000);
+    }
+}
+
+void TestResultCache() {
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "curly cat curly tail"s, DocumentStatus::ACTUAL, { 7 });
+    search_server.AddDocument(2, "curly dog and fancy collar"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(3, "big cat fancy collar"s, DocumentStatus::BANNED, { 8 });
+    SearchServer uncached = search_server;
+    auto cache = make_shared<ResultCache>(100);
+    search_server.SetResultCache(cache);
+
+    const auto expect_same = [](const vector<Document>& lhs, const vector<Document>& rhs) {
+        ASSERT_EQUAL(lhs.size(), rhs.size());
+        for (size_t index = 0; index < lhs.size(); ++index) {
+            ASSERT_EQUAL(lhs[index].id, rhs[index].id);
+            ASSERT_EQUAL(lhs[index].relevance, rhs[index].relevance);
+        }
+    };
+
+    //  -  : ,   -  
+    expect_same(search_server.FindTopDocuments("curly cat -dog"s), uncached.FindTopDocuments("curly cat -dog"s));
+    ASSERT_EQUAL(cache->GetMissCount(), 1u);
+    expect_same(search_server.FindTopDocuments("cat and curly -dog curly"s), uncached.FindTopDocuments("curly cat -dog"s));
+    expect_same(search_server.FindTopDocuments(execution::par, "-dog cat curly"s, DocumentStatus::ACTUAL), uncached.FindTopDocuments("curly cat -dog"s));
+    ASSERT_EQUAL(cache->GetHitCount(), 2u);
+    //  ,    - -  
+    expect_same(search_server.FindTopDocuments("curly cat -dog"s, DocumentStatus::BANNED), uncached.FindTopDocuments("curly cat -dog"s, DocumentStatus::BANNED));
+    expect_same(search_server.FindTopDocuments("curly cat -dog"s, DocumentStatus::ACTUAL, 1, 1), uncached.FindTopDocuments("curly cat -dog"s, DocumentStatus::ACTUAL, 1, 1));
+    expect_same(search_server.FindTopDocuments("curly cat"s), uncached.FindTopDocuments("curly cat"s));
+    ASSERT_EQUAL(cache->GetMissCount(), 4u);
+    //      
+    search_server.FindTopDocuments("curly cat -dog"s, [](int, DocumentStatus, int) { return true; });
+    ASSERT_EQUAL(cache->GetHitCount() + cache->GetMissCount(), 6u);
+
+    //    ,     
+    search_server.AddDocument(4, "cat cat cat"s, DocumentStatus::ACTUAL, { 2 });
+    uncached.AddDocument(4, "cat cat cat"s, DocumentStatus::ACTUAL, { 2 });
+    expect_same(search_server.FindTopDocuments("curly cat -dog"s), uncached.FindTopDocuments("curly cat -dog"s));
+    search_server.RemoveDocument(1);
+    uncached.RemoveDocument(1);
+    expect_same(search_server.FindTopDocuments("curly cat -dog"s), uncached.FindTopDocuments("curly cat -dog"s));
+    ASSERT_EQUAL(cache->GetMissCount(), 6u);
+
+    //   ,   ;      
+    SearchServer copy = search_server;
+    copy.FindTopDocuments("curly cat -dog"s);
+    ASSERT_EQUAL(cache->GetHitCount(), 3u);
+    copy.RemoveDocument(4);
+    ASSERT(copy.FindTopDocuments("curly cat -dog"s).empty());
+    expect_same(search_server.FindTopDocuments("curly cat -dog"s), uncached.FindTopDocuments("curly cat -dog"s));
+    ASSERT_EQUAL(cache->GetHitCount(), 4u);
+
+    // ProcessQueries      
+    const vector<string> queries = { "curly"s, "cat"s, "fancy collar"s, "curly"s, "cat"s, "fancy collar"s, "dog"s, "curly"s };
+    const auto cached_results = ProcessQueries(search_server, queries);
+    const auto expected_results = ProcessQueries(uncached, queries);
+    for (size_t index = 0; index < queries.size(); ++index) {
+        expect_same(cached_results[index], expected_results[index]);
+    }
+
+    // RequestQueue    :    - 
+    {
+        const uint64_t hits_before = cache->GetHitCount();
+        const uint64_t misses_before = cache->GetMissCount();
+        RequestQueue request_queue(search_server);
+        for (int i = 0; i < 5; ++i) {
+            expect_same(request_queue.AddFindRequest("tail cat"s), uncached.FindTopDocuments("tail cat"s));
+        }
+        request_queue.AddFindRequest("tail cat"s, DocumentStatus::BANNED);
+        ASSERT_EQUAL(cache->GetMissCount() - misses_before, 2u);
+        ASSERT_EQUAL(cache->GetHitCount() - hits_before, 4u);
+        ASSERT_EQUAL(request_queue.GetStatistics().request_count, 6);
+    }
+
+    //   ,    
+    ResultCache small_cache(2);
+    const auto make_key = [](TermDictionary::TermId term_id) { return ResultCacheKey{ { term_id }, {}, DocumentStatus::ACTUAL, 0, 5, 1 }; };
+    small_cache.Insert(make_key(1), { { 1, 0.5, 1 } });
+    small_cache.Insert(make_key(2), { { 2, 0.5, 1 } });
+    ASSERT(small_cache.Find(make_key(1)).has_value());
+    small_cache.Insert(make_key(3), { { 3, 0.5, 1 } });
+    ASSERT_EQUAL(small_cache.GetSize(), 2u);
+    ASSERT(small_cache.Find(make_key(1)).has_value());
+    ASSERT(!small_cache.Find(make_key(2)).has_value());
+    ASSERT_EQUAL(small_cache.Find(make_key(3))->front().id, 3);
+}
+
 void TestRemoveDuplicates() {
     SearchServer search_server("and with"s);
 
@@ -466,6 +735,904 @@ void TestRemoveDuplicates() {
     RemoveDuplicates(search_server);
     cout.clear(ios_base::goodbit);
     ASSERT_EQUAL(search_server.GetDocumentCount(), 5);
+    ASSERT(vector<int>(search_server.begin(), search_server.end()) == (vector<int>{ 1, 2, 6, 8, 9 }));
+
+    //       id,      
+    {
+        SearchServer server("and"s);
+        AddDocument(server, 30, "cat and dog"s, DocumentStatus::ACTUAL, { 1 });
+        AddDocument(server, 20, "dog cat"s, DocumentStatus::ACTUAL, { 1 });
+        AddDocument(server, 25, "dog"s, DocumentStatus::ACTUAL, { 1 });
+        AddDocument(server, 10, "cat dog cat"s, DocumentStatus::ACTUAL, { 1 });
+        cout.clear(ios_base::badbit);
+        RemoveDuplicates(server);
+        cout.clear(ios_base::goodbit);
+        ASSERT(vector<int>(server.begin(), server.end()) == (vector<int>{ 25, 10 }));
+    }
+}
+
+void TestNearDuplicates() {
+    const vector<string> words = {
+        "white"s, "cat"s, "fancy"s, "collar"s, "fluffy"s, "tail"s, "groomed"s, "dog"s, "expressive"s, "eyes"s,
+        "starling"s, "eugene"s, "black"s, "curly"s, "hair"s, "nasty"s, "rat"s, "funny"s, "pet"s, "parrot"s,
+    };
+    const auto join = [&](int first, int last, const string& extra) {
+        string text = extra;
+        for (int index = first; index < last; ++index) {
+            text += " "s + words[index];
+        }
+        return text;
+    };
+    SearchServer search_server("and"s);
+    //  9   11,    0.82
+    search_server.AddDocument(7, join(0, 10, ""s), DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(3, join(0, 9, words[10]), DocumentStatus::ACTUAL, { 1 });
+    //    ,    7
+    search_server.AddDocument(12, join(0, 10, "and"s), DocumentStatus::ACTUAL, { 1 });
+    //    ,     
+    search_server.AddDocument(5, join(10, 20, ""s), DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(9, join(11, 20, words[0]), DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(1, join(5, 15, ""s), DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(2, "cat dog"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(4, "and"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(6, "and"s, DocumentStatus::ACTUAL, { 1 });
+
+    const auto clusters = FindNearDuplicates(search_server, 0.7);
+    ASSERT_EQUAL(clusters.size(), 2u);
+    ASSERT(clusters[0].document_ids == (vector<int>{ 3, 7, 12 }));
+    ASSERT(clusters[1].document_ids == (vector<int>{ 5, 9 }));
+    for (const NearDuplicateCluster& cluster : clusters) {
+        ASSERT_EQUAL(cluster.similarities.size(), cluster.document_ids.size());
+        ASSERT_EQUAL(cluster.similarities[0], 1.);
+        for (const double similarity : cluster.similarities) {
+            ASSERT(similarity >= 0.7);
+        }
+    }
+    //      
+    ASSERT_EQUAL(clusters[0].similarities[1], clusters[0].similarities[2]);
+    //   1    
+    const auto exact_clusters = FindNearDuplicates(search_server, 1.);
+    ASSERT_EQUAL(exact_clusters.size(), 1u);
+    ASSERT(exact_clusters[0].document_ids == (vector<int>{ 7, 12 }));
+    //    
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 9);
+
+    //        id
+    const auto removed_clusters = RemoveNearDuplicates(search_server, 0.7);
+    ASSERT_EQUAL(removed_clusters.size(), 2u);
+    ASSERT(vector<int>(search_server.begin(), search_server.end()) == (vector<int>{ 3, 5, 1, 2, 4, 6 }));
+    ASSERT(FindNearDuplicates(search_server, 0.7).empty());
+}
+
+void TestRemoveDocument() {
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, { 1, 2 });
+    search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, { 1, 2 });
+    search_server.AddDocument(3, "nasty rat with curly hair"s, DocumentStatus::ACTUAL, { 1, 2 });
+
+    //   pet  rat   1,        
+    search_server.RemoveDocument(1);
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 2u);
+    {
+        const auto documents = search_server.FindTopDocuments("pet"s);
+        ASSERT_EQUAL(documents.size(), 1u);
+        ASSERT_EQUAL(documents[0].id, 2);
+    }
+    {
+        const auto [words, status] = search_server.MatchDocument("nasty rat"s, 3);
+        ASSERT_EQUAL(words.size(), 2u);
+    }
+
+    //  funny     2,       
+    search_server.RemoveDocument(std::execution::par, 2);
+    ASSERT(search_server.FindTopDocuments("funny pet"s).empty());
+    ASSERT_EQUAL(search_server.FindTopDocuments("curly"s).size(), 1u);
+
+    //      
+    search_server.RemoveDocument(42);
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 1u);
+}
+
+void TestSparseDocumentIds() {
+    SearchServer search_server;
+    search_server.AddDocument(100, "white cat"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(3, "black cat"s, DocumentStatus::BANNED, { 2 });
+    search_server.AddDocument(57, "black dog"s, DocumentStatus::ACTUAL, { 3 });
+
+    //        
+    {
+        const auto documents = search_server.FindTopDocuments("black"s, [](int document_id, DocumentStatus, int) { return document_id < 50; });
+        ASSERT_EQUAL(documents.size(), 1u);
+        ASSERT_EQUAL(documents[0].id, 3);
+        ASSERT_EQUAL(documents[0].rating, 2);
+    }
+    search_server.RemoveDocument(100);
+    search_server.AddDocument(100, "white dog"s, DocumentStatus::ACTUAL, { 4 });
+    {
+        const auto documents = search_server.FindTopDocuments("white"s);
+        ASSERT_EQUAL(documents.size(), 1u);
+        ASSERT_EQUAL(documents[0].id, 100);
+        ASSERT_EQUAL(documents[0].rating, 4);
+    }
+    {
+        const auto [words, status] = search_server.MatchDocument("black cat"s, 3);
+        ASSERT_EQUAL(words.size(), 2u);
+        ASSERT(status == DocumentStatus::BANNED);
+    }
+}
+
+void TestTopDocuments() {
+    //           
+    vector<Document> documents;
+    for (int id = 0; id < 100; ++id) {
+        //        ,   
+        documents.push_back({ id, (id % 17) / 3 * 0.25, (id * 7) % 100 });
+    }
+    TopDocuments top_documents(MAX_RESULT_DOCUMENT_COUNT);
+    for (const Document& document : documents) {
+        top_documents.Add(document);
+    }
+    const vector<Document> top = top_documents.Extract();
+
+    sort(documents.begin(), documents.end(), IsMoreRelevant);
+    ASSERT_EQUAL(top.size(), static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT));
+    for (size_t i = 0; i < top.size(); ++i) {
+        ASSERT_EQUAL(top[i].id, documents[i].id);
+    }
+
+    SearchServer search_server("and with"s);
+    search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, { 7 });
+    search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(3, "funny pet and not very nasty rat"s, DocumentStatus::ACTUAL, { 2 });
+    search_server.AddDocument(4, "pet with rat and rat and rat"s, DocumentStatus::ACTUAL, { 3 });
+    search_server.AddDocument(5, "nasty rat with curly hair"s, DocumentStatus::ACTUAL, { 4 });
+    search_server.AddDocument(6, "very funny pet"s, DocumentStatus::ACTUAL, { 5 });
+    search_server.AddDocument(7, "curly funny pet"s, DocumentStatus::ACTUAL, { 6 });
+    const auto seq_documents = search_server.FindTopDocuments(std::execution::seq, "funny curly nasty rat"s);
+    const auto par_documents = search_server.FindTopDocuments(std::execution::par, "funny curly nasty rat"s);
+    ASSERT_EQUAL(seq_documents.size(), static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT));
+    ASSERT_EQUAL(par_documents.size(), seq_documents.size());
+    for (size_t i = 0; i < seq_documents.size(); ++i) {
+        ASSERT_EQUAL(par_documents[i].id, seq_documents[i].id);
+        ASSERT(i == 0 || !IsMoreRelevant(seq_documents[i], seq_documents[i - 1]));
+    }
+}
+
+void TestFindTopDocumentsWindow() {
+    SearchServer search_server;
+    for (int id = 0; id < 12; ++id) {
+        search_server.AddDocument(id, "cat"s + string(id % 4 + 1, 's') + " cat dog"s, DocumentStatus::ACTUAL, { id });
+    }
+    search_server.AddDocument(12, "cat"s, DocumentStatus::BANNED, { 100 });
+
+    const auto all_documents = search_server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, 0, 100);
+    ASSERT_EQUAL(all_documents.size(), 12u);
+    //     MAX_RESULT_DOCUMENT_COUNT    
+    {
+        const auto documents = search_server.FindTopDocuments("cat"s);
+        ASSERT_EQUAL(documents.size(), static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT));
+        for (size_t i = 0; i < documents.size(); ++i) {
+            ASSERT_EQUAL(documents[i].id, all_documents[i].id);
+        }
+    }
+    {
+        const auto documents = search_server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, 7, 3);
+        ASSERT_EQUAL(documents.size(), 3u);
+        for (size_t i = 0; i < documents.size(); ++i) {
+            ASSERT_EQUAL(documents[i].id, all_documents[7 + i].id);
+        }
+    }
+    ASSERT(search_server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, 12, 5).empty());
+    ASSERT(search_server.FindTopDocuments("cat"s, DocumentStatus::ACTUAL, 0, 0).empty());
+
+    //  Paginator      
+    auto pages = PaginateQuery(search_server, "cat"s, 5);
+    ASSERT_EQUAL(pages.GetPage(1).size(), 5u);
+    ASSERT_EQUAL(pages.GetPage(1)[0].id, all_documents[5].id);
+    size_t page_count = 0;
+    size_t document_index = 0;
+    for (const auto& page : pages) {
+        ++page_count;
+        for (const Document& document : page) {
+            ASSERT_EQUAL(document.id, all_documents[document_index++].id);
+        }
+    }
+    ASSERT_EQUAL(page_count, 3u);
+    ASSERT_EQUAL(document_index, all_documents.size());
+
+    //      ,  ,     
+    {
+        vector<int> results(37);
+        iota(results.begin(), results.end(), 0);
+        int source_calls = 0;
+        LazyPaginator counted_pages([&](size_t offset, size_t count) {
+            ++source_calls;
+            const size_t first = min(offset, results.size());
+            return vector<int>(results.begin() + first, results.begin() + min(offset + count, results.size()));
+            }, 3);
+        int expected = 0;
+        size_t counted_page_count = 0;
+        for (const auto& page : counted_pages) {
+            ++counted_page_count;
+            for (const int value : page) {
+                ASSERT_EQUAL(value, expected++);
+            }
+        }
+        ASSERT_EQUAL(counted_page_count, 13u);
+        ASSERT_EQUAL(expected, 37);
+        ASSERT_EQUAL(source_calls, 5);
+        ASSERT(counted_pages.GetPage(20).empty());
+        ASSERT_EQUAL(source_calls, 5);
+    }
+}
+
+void TestScoreAccumulatorReuse() {
+    SearchServer big_server;
+    for (int id = 0; id < 50; ++id) {
+        big_server.AddDocument(id, "cat dog"s + string(id % 7, 'g'), DocumentStatus::ACTUAL, { id });
+    }
+    SearchServer small_server;
+    small_server.AddDocument(0, "cat"s, DocumentStatus::ACTUAL, { 1 });
+    small_server.AddDocument(1, "dog"s, DocumentStatus::ACTUAL, { 2 });
+
+    const auto first = big_server.FindTopDocuments("cat -doggg"s);
+    //   ,       
+    ASSERT_EQUAL(small_server.FindTopDocuments("dog"s).size(), 1u);
+    const auto second = big_server.FindTopDocuments("cat -doggg"s);
+    ASSERT_EQUAL(first.size(), second.size());
+    for (size_t i = 0; i < first.size(); ++i) {
+        ASSERT_EQUAL(first[i].id, second[i].id);
+        ASSERT_EQUAL(first[i].relevance, second[i].relevance);
+    }
+
+    //        ,      
+    int predicate_calls = 0;
+    const auto documents = big_server.FindTopDocuments("cat dog"s, [&](int document_id, DocumentStatus, int) {
+        ++predicate_calls;
+        return !small_server.FindTopDocuments("cat"s).empty() && document_id % 2 == 0;
+        });
+    ASSERT_EQUAL(predicate_calls, 50);
+    ASSERT_EQUAL(documents.size(), static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT));
+    for (const Document& document : documents) {
+        ASSERT_EQUAL(document.id % 2, 0);
+    }
+
+    //       
+    {
+        auto accumulator = ScoreAccumulator::Acquire(10, 100);
+        accumulator->Exclude(105);
+        accumulator->Add(103, 1., [](int) { return true; });
+        accumulator->Add(109, 2., [](int) { return false; });
+        accumulator->Add(103, 0.5, [](int) { return true; });
+        vector<pair<int, double>> accepted;
+        accumulator->ForEachAccepted([&](int slot, double score) {
+            accepted.emplace_back(slot, score);
+            });
+        ASSERT(accumulator->IsExcluded(105));
+        ASSERT(!accumulator->IsExcluded(103));
+        ASSERT_EQUAL(accepted.size(), 1u);
+        ASSERT_EQUAL(accepted[0].first, 103);
+        ASSERT_EQUAL(accepted[0].second, 1.5);
+    }
+}
+
+void TestParallelFindTopDocumentsMatchesSequential() {
+    const vector<string> dictionary = { "cat"s, "dog"s, "rat"s, "pet"s, "big"s, "old"s, "red"s, "fat"s, "fox"s, "owl"s };
+    SearchServer search_server("old"s);
+    for (int id = 0; id < 300; ++id) {
+        string text;
+        for (int i = 0; i < 2 + id % 9; ++i) {
+            text += dictionary[(id * 7 + i * i * 3) % dictionary.size()] + " "s;
+        }
+        search_server.AddDocument(id, text, id % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, { id % 13 });
+    }
+
+    search_server.SetThreadPool(std::make_shared<ThreadPool>(3));
+    const auto even_predicate = [](int document_id, DocumentStatus, int) { return document_id % 2 == 0; };
+    const auto by_id = [](const Document& lhs, const Document& rhs) { return lhs.id < rhs.id; };
+    for (const auto mode : { ParallelSearchMode::AUTO, ParallelSearchMode::BY_TERMS, ParallelSearchMode::BY_DOCUMENTS }) {
+        search_server.SetParallelSearchMode(mode);
+        for (const string& query : { "cat dog -fox"s, "rat pet big red fat fox owl -cat"s, "owl"s, "dog -dog"s, "old"s,
+            "cat dog rat pet big red fat fox owl cat dog rat pet -owl"s }) {
+            auto seq_documents = search_server.FindTopDocuments(std::execution::seq, query, even_predicate, 0, 1000);
+            auto par_documents = search_server.FindTopDocuments(std::execution::par, query, even_predicate, 0, 1000);
+            ASSERT_EQUAL(par_documents.size(), seq_documents.size());
+            for (size_t i = 0; i < seq_documents.size(); ++i) {
+                ASSERT_EQUAL(par_documents[i].relevance, seq_documents[i].relevance);
+                ASSERT_EQUAL(par_documents[i].rating, seq_documents[i].rating);
+            }
+            //           ,   
+            sort(seq_documents.begin(), seq_documents.end(), by_id);
+            sort(par_documents.begin(), par_documents.end(), by_id);
+            for (size_t i = 0; i < seq_documents.size(); ++i) {
+                ASSERT_EQUAL(par_documents[i].id, seq_documents[i].id);
+                ASSERT_EQUAL(par_documents[i].relevance, seq_documents[i].relevance);
+            }
+        }
+    }
+}
+
+void TestMaxScore() {
+    const vector<string> dictionary = { "cat"s, "dog"s, "rat"s, "pet"s, "big"s, "old"s, "red"s, "fat"s, "fox"s, "owl"s, "eel"s, "yak"s };
+    //     ;     MAX_SCORE,   
+    SearchServer exhaustive("old"s);
+    exhaustive.SetSegmentCapacity(3000);
+    for (int id = 0; id < 10000; ++id) {
+        string text;
+        for (int i = 0; i < 1 + id % 11; ++i) {
+            const int key = (id * 131 + i * 71) % 1000;
+            text += dictionary[key * key * dictionary.size() / 1000000] + " "s;
+        }
+        exhaustive.AddDocument(id, text, id % 7 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, { id });
+    }
+    vector<int> removed_ids;
+    for (int id = 5; id < 10000; id += 13) {
+        removed_ids.push_back(id);
+    }
+    exhaustive.RemoveDocuments(removed_ids);
+    SearchServer pruned = exhaustive;
+    pruned.SetScoringMode(ScoringMode::MAX_SCORE);
+
+    const auto expect_same = [](const vector<Document>& lhs, const vector<Document>& rhs) {
+        ASSERT_EQUAL(lhs.size(), rhs.size());
+        for (size_t index = 0; index < lhs.size(); ++index) {
+            ASSERT_EQUAL(lhs[index].id, rhs[index].id);
+            ASSERT_EQUAL(lhs[index].relevance, rhs[index].relevance);
+            ASSERT_EQUAL(lhs[index].rating, rhs[index].rating);
+        }
+    };
+    const auto even_predicate = [](int document_id, DocumentStatus, int) { return document_id % 2 == 0; };
+    const vector<string> queries = { "yak"s, "cat yak"s, "eel yak owl -cat"s, "cat dog rat pet big red fat fox owl eel yak"s, "dog -dog"s, "old"s, "cat dog"s };
+    const auto expect_same_results = [&] {
+        for (const string& query : queries) {
+            expect_same(pruned.FindTopDocuments(query), exhaustive.FindTopDocuments(query));
+            expect_same(pruned.FindTopDocuments(query, DocumentStatus::BANNED), exhaustive.FindTopDocuments(query, DocumentStatus::BANNED));
+            expect_same(pruned.FindTopDocuments(query, even_predicate, 3, 4), exhaustive.FindTopDocuments(query, even_predicate, 3, 4));
+            expect_same(pruned.FindTopDocuments(query, DocumentStatus::ACTUAL, 0, 1), exhaustive.FindTopDocuments(query, DocumentStatus::ACTUAL, 0, 1));
+            expect_same(pruned.FindTopDocuments(execution::par, query), exhaustive.FindTopDocuments(query));
+        }
+    };
+    pruned.SetThreadPool(std::make_shared<ThreadPool>(3));
+    pruned.SetParallelSearchMode(ParallelSearchMode::BY_DOCUMENTS);
+    expect_same_results();
+    //    ,     
+    for (SearchServer* server : { &exhaustive, &pruned }) {
+        server->AddDocument(20000, "yak"s, DocumentStatus::ACTUAL, { 1 });
+        server->AddDocument(20001, "owl owl eel"s, DocumentStatus::ACTUAL, { 2 });
+    }
+    expect_same_results();
+
+    //     ,         
+    SearchServer sparse;
+    sparse.AddDocument(0, "rare"s, DocumentStatus::ACTUAL, { 1 });
+    for (int id = 1; id < 10000; ++id) {
+        sparse.AddDocument(id, "common filler"s, DocumentStatus::ACTUAL, { 1 });
+    }
+    uint64_t visited_before = SearchServer::GetVisitedPostingCount();
+    const auto expected = sparse.FindTopDocuments("rare common"s, DocumentStatus::ACTUAL, 0, 1);
+    const uint64_t exhaustive_visited = SearchServer::GetVisitedPostingCount() - visited_before;
+    sparse.SetScoringMode(ScoringMode::MAX_SCORE);
+    visited_before = SearchServer::GetVisitedPostingCount();
+    expect_same(sparse.FindTopDocuments("rare common"s, DocumentStatus::ACTUAL, 0, 1), expected);
+    const uint64_t pruned_visited = SearchServer::GetVisitedPostingCount() - visited_before;
+    ASSERT_EQUAL(exhaustive_visited, 10000u);
+    ASSERT(pruned_visited < exhaustive_visited / 2);
+}
+
+void TestThreadPool() {
+    for (size_t thread_count : { 0u, 1u, 3u }) {
+        ThreadPool thread_pool(thread_count);
+        ASSERT_EQUAL(thread_pool.GetThreadCount(), thread_count);
+        ASSERT_EQUAL(thread_pool.Submit([] { return 42; }).get(), 42);
+
+        //  ParallelFor       
+        vector<int> sums(10, 0);
+        thread_pool.ParallelFor(sums.size(), [&](size_t i) {
+            vector<int> values(100, 0);
+            thread_pool.ParallelFor(values.size(), [&](size_t j) { values[j] = static_cast<int>(i + j); });
+            for (const int value : values) {
+                sums[i] += value;
+            }
+            });
+        for (size_t i = 0; i < sums.size(); ++i) {
+            ASSERT_EQUAL(sums[i], static_cast<int>(100 * i + 4950));
+        }
+
+        bool is_thrown = false;
+        try {
+            thread_pool.ParallelFor(10, [](size_t i) {
+                if (i == 7) {
+                    throw std::runtime_error("task failed"s);
+                }
+                });
+        }
+        catch (const std::runtime_error&) {
+            is_thrown = true;
+        }
+        ASSERT(is_thrown);
+    }
+
+    //    
+    SearchServer search_server("and with"s);
+    search_server.SetThreadPool(std::make_shared<ThreadPool>(2));
+    search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, { 7 });
+    search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(3, "nasty rat with curly hair"s, DocumentStatus::ACTUAL, { 2 });
+    ASSERT_EQUAL(search_server.FindTopDocuments(std::execution::par, "curly rat -funny"s).size(), 1u);
+    const auto [words, status] = search_server.MatchDocument(std::execution::par, "curly curly hair -dog"s, 3);
+    ASSERT_EQUAL(words.size(), 2u);
+    ASSERT_EQUAL(words[0], "curly"s);
+    ASSERT_EQUAL(ProcessQueries(search_server, { "funny"s, "rat"s, "dog"s })[1].size(), 2u);
+}
+
+void TestCachedInverseDocumentFreq() {
+    SearchServer search_server;
+    search_server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(2, "black dog"s, DocumentStatus::ACTUAL, { 1 });
+
+    //     IDF   
+    {
+        const auto documents = search_server.FindTopDocuments("cat"s);
+        ASSERT_EQUAL(documents.size(), 1u);
+        ASSERT(std::abs(documents[0].relevance - log(2.0) * 0.5) < INACCURACY);
+    }
+    //        
+    search_server.AddDocument(3, "black cat"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(4, "grey mouse"s, DocumentStatus::ACTUAL, { 1 });
+    {
+        const auto documents = search_server.FindTopDocuments(std::execution::par, "cat"s);
+        ASSERT_EQUAL(documents.size(), 2u);
+        ASSERT(std::abs(documents[0].relevance - log(2.0) * 0.5) < INACCURACY);
+    }
+    search_server.RemoveDocument(2);
+    {
+        const auto documents = search_server.FindTopDocuments("cat"s);
+        ASSERT_EQUAL(documents.size(), 2u);
+        ASSERT(std::abs(documents[0].relevance - log(3.0 / 2.0) * 0.5) < INACCURACY);
+    }
+}
+
+void TestTermDictionary() {
+    TermDictionary dictionary;
+    const TermDictionary::TermId cat_id = dictionary.Intern("cat"s);
+    const TermDictionary::TermId dog_id = dictionary.Intern("dog"s);
+    ASSERT_EQUAL(cat_id, 0u);
+    ASSERT_EQUAL(dog_id, 1u);
+    ASSERT_EQUAL(dictionary.Intern("cat"s), cat_id);
+    ASSERT_EQUAL(dictionary.Find("dog"s), dog_id);
+    ASSERT_EQUAL(dictionary.Find("rat"s), TermDictionary::NO_TERM);
+
+    //      ,     
+    const std::string_view cat = dictionary.GetTerm(cat_id);
+    const string long_word(100000, 'a');
+    const TermDictionary::TermId long_id = dictionary.Intern(long_word);
+    for (int i = 0; i < 20000; ++i) {
+        dictionary.Intern("word"s + to_string(i));
+    }
+    ASSERT_EQUAL(cat.data(), dictionary.GetTerm(cat_id).data());
+    ASSERT_EQUAL(dictionary.GetTerm(long_id), long_word);
+    ASSERT_EQUAL(dictionary.GetTermCount(), 20003u);
+
+    //        ; ,    ,
+    //   ,     
+    TermDictionary copy = dictionary;
+    ASSERT_EQUAL(copy.GetTerm(cat_id), "cat"s);
+    ASSERT_EQUAL(copy.GetTerm(cat_id).data(), cat.data());
+    ASSERT_EQUAL(copy.Find("word19999"s), dictionary.Find("word19999"s));
+    const TermDictionary::TermId fox_id = copy.Intern("fox"s);
+    ASSERT_EQUAL(dictionary.Intern("owl"s), fox_id);
+    ASSERT_EQUAL(copy.Find("owl"s), TermDictionary::NO_TERM);
+    ASSERT_EQUAL(dictionary.Find("fox"s), TermDictionary::NO_TERM);
+    ASSERT_EQUAL(copy.GetTerm(fox_id), "fox"s);
+    ASSERT_EQUAL(dictionary.GetTerm(fox_id), "owl"s);
+
+    //  ,    ,      
+    SearchServer search_server;
+    search_server.AddDocument(1, "white cat"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(2, "black cat"s, DocumentStatus::ACTUAL, { 2 });
+    ASSERT_EQUAL(search_server.FindTopDocuments("white unknown -missing"s).size(), 1u);
+    const auto [words, status] = search_server.MatchDocument("white cat cat unknown"s, 1);
+    ASSERT_EQUAL(words.size(), 2u);
+    ASSERT_EQUAL(words[0], "cat"s);
+    ASSERT_EQUAL(words[1], "white"s);
+}
+
+void TestPersistentArray() {
+    PersistentArray<int> array;
+    ASSERT(array.empty());
+    for (int i = 0; i < 100000; ++i) {
+        array.push_back(i);
+    }
+    ASSERT_EQUAL(array.size(), 100000u);
+    ASSERT_EQUAL(array[99999], 99999);
+
+    //        
+    PersistentArray<int> copy = array;
+    copy.Mutable(5) = -5;
+    copy.push_back(100000);
+    ASSERT_EQUAL(array[5], 5);
+    ASSERT_EQUAL(copy[5], -5);
+    ASSERT_EQUAL(&array[50000], &copy[50000]);
+    ASSERT_EQUAL(array.size(), 100000u);
+    ASSERT_EQUAL(copy.size(), 100001u);
+
+    copy.resize(200000);
+    ASSERT_EQUAL(copy[150000], 0);
+    long long sum = 0;
+    size_t count = 0;
+    array.ForEach([&](int value) {
+        sum += value;
+        ++count;
+        });
+    ASSERT_EQUAL(count, 100000u);
+    ASSERT_EQUAL(sum, 99999LL * 100000 / 2);
+    ASSERT_EQUAL(PersistentArray<int>(std::vector<int>{ 1, 2, 3 })[2], 3);
+
+    //  id :     ,     
+    OrdinalMap ordinals;
+    for (int id = 0; id < 1000; ++id) {
+        ASSERT(ordinals.Insert(id * 7, id));
+    }
+    ASSERT(!ordinals.Insert(7, 100));
+    const OrdinalMap ordinals_copy = ordinals;
+    for (int id = 0; id < 1000; id += 2) {
+        ASSERT(ordinals.Erase(id * 7));
+    }
+    ASSERT(!ordinals.Erase(0));
+    ASSERT_EQUAL(ordinals.size(), 500u);
+    ASSERT_EQUAL(ordinals.Find(7), 1);
+    ASSERT_EQUAL(ordinals.Find(14), OrdinalMap::NO_ORDINAL);
+    ASSERT_EQUAL(ordinals_copy.Find(14), 2);
+    ASSERT_EQUAL(ordinals_copy.size(), 1000u);
+    for (int id = 1000; id < 3000; ++id) {
+        ordinals.Insert(id * 7, id);
+    }
+    ASSERT_EQUAL(ordinals.Find(7 * 2999), 2999);
+    ASSERT_EQUAL(ordinals.Find(7 * 999), 999);
+    size_t ordinal_sum = 0;
+    ordinals.ForEach([&](int id, int ordinal) {
+        ASSERT_EQUAL(id, ordinal * 7);
+        ordinal_sum += static_cast<size_t>(ordinal);
+        });
+    ASSERT_EQUAL(ordinal_sum, 500u * 500 + 2999u * 3000 / 2 - 999u * 1000 / 2);
+}
+
+void TestPostingList() {
+    //      VByte;     ,   32 
+    struct Entry {
+        int ordinal;
+        uint32_t count;
+        uint32_t word_count;
+    };
+    vector<Entry> entries;
+    int ordinal = 0;
+    for (int i = 0; i < 3 * static_cast<int>(PostingList::BLOCK_SIZE) + 50; ++i) {
+        ordinal += i == 200 ? 1000000000 : 1 + (i * 7) % 13;
+        const uint32_t word_count = i == 300 ? 4000000000u : 1 + static_cast<uint32_t>(i * 31) % 500;
+        entries.push_back({ ordinal, 1 + static_cast<uint32_t>(i) % word_count, word_count });
+    }
+    PostingList postings;
+    for (const Entry& entry : entries) {
+        postings.Append(entry.ordinal, entry.count, entry.word_count);
+    }
+    ASSERT_EQUAL(postings.size(), entries.size());
+    ASSERT_EQUAL(postings.GetBlockCount(), 4u);
+
+    // TF         
+    vector<Entry> raw_entries;
+    postings.ForEachRaw([&](int ordinal, uint32_t count, uint32_t word_count) {
+        raw_entries.push_back({ ordinal, count, word_count });
+        });
+    ASSERT_EQUAL(raw_entries.size(), entries.size());
+    size_t index = 0;
+    const size_t decoded_count = postings.ForEach([&](int ordinal, double term_freq) {
+        ASSERT_EQUAL(ordinal, entries[index].ordinal);
+        ASSERT_EQUAL(raw_entries[index].count, entries[index].count);
+        ASSERT_EQUAL(raw_entries[index].word_count, entries[index].word_count);
+        ASSERT_EQUAL(term_freq, entries[index].count * (1.0 / entries[index].word_count));
+        ++index;
+        });
+    ASSERT_EQUAL(index, entries.size());
+    ASSERT_EQUAL(decoded_count, entries.size());
+
+    //        
+    ASSERT(postings.Contains(entries[130].ordinal));
+    ASSERT(!postings.Contains(entries[130].ordinal + 1));
+    ASSERT(!postings.Contains(entries.back().ordinal + 1));
+    ASSERT_EQUAL(postings.FindBlock(entries[300].ordinal), 2u);
+    ASSERT_EQUAL(postings.FindBlock(entries[300].ordinal, 3), 3u);
+    ASSERT_EQUAL(postings.FindBlock(entries.back().ordinal + 1), postings.GetBlockCount());
+    vector<int> range;
+    ASSERT_EQUAL(postings.ForEach(entries[10].ordinal, entries[20].ordinal, [&](int ordinal, double) {
+        range.push_back(ordinal);
+        }), PostingList::BLOCK_SIZE);
+    ASSERT_EQUAL(range.size(), 10u);
+    ASSERT_EQUAL(range.front(), entries[10].ordinal);
+
+    PostingCursor cursor;
+    cursor.Reset(postings, entries[5].ordinal + 1);
+    ASSERT_EQUAL(cursor.GetOrdinal(), entries[6].ordinal);
+    cursor.Next();
+    ASSERT_EQUAL(cursor.GetOrdinal(), entries[7].ordinal);
+    cursor.Seek(entries[400].ordinal);
+    ASSERT_EQUAL(cursor.GetOrdinal(), entries[400].ordinal);
+    ASSERT_EQUAL(cursor.GetTermFreq(), entries[400].count * (1.0 / entries[400].word_count));
+    ASSERT_EQUAL(cursor.GetDecodedCount(), PostingList::BLOCK_SIZE + 50);
+    cursor.Seek(entries.back().ordinal + 1);
+    ASSERT(cursor.IsEnd());
+
+    //       ,       
+    const PostingList view = PostingList::View(postings.GetBlocks().begin(), postings.GetData().begin(),
+        postings.GetData().size(), postings.size());
+    ASSERT(view.Contains(entries[200].ordinal));
+    ASSERT_EQUAL(view.GetDataSize(), postings.GetDataSize());
+
+    //         ,      
+    ASSERT(view.IsValid(entries.back().ordinal + 1));
+    ASSERT(!view.IsValid(entries.back().ordinal));
+    const auto make_view = [&](const vector<uint8_t>& data, size_t data_size) {
+        return PostingList::View(postings.GetBlocks().begin(), data.data(), data_size, postings.size());
+    };
+    const vector<uint8_t> data(postings.GetData().begin(), postings.GetData().end());
+    ASSERT(!make_view(data, data.size() - 1).IsValid(entries.back().ordinal + 1));
+    for (const uint8_t bad_width : { uint8_t{ 33 }, static_cast<uint8_t>(data[0] + 1) }) {
+        vector<uint8_t> bad_data = data;
+        bad_data[0] = bad_width;
+        ASSERT(!make_view(bad_data, bad_data.size()).IsValid(entries.back().ordinal + 1));
+    }
+    //        ,       
+    {
+        vector<uint8_t> bad_data = data;
+        bad_data[3] = 0xff;
+        const PostingList bad_view = make_view(bad_data, bad_data.size());
+        ASSERT(bad_view.IsValid(entries.back().ordinal + 1));
+        try {
+            bad_view.Contains(entries[0].ordinal);
+            ASSERT(false);
+        }
+        catch (const std::runtime_error&) {
+        }
+    }
+
+    const PostingList copy = postings;
+    postings.Append(entries.back().ordinal + 1, 1, 1);
+    ASSERT_EQUAL(copy.size(), entries.size());
+    ASSERT(!copy.Contains(entries.back().ordinal + 1));
+    ASSERT(postings.Contains(entries.back().ordinal + 1));
+
+    //        16 
+    SearchServer search_server;
+    for (int id = 0; id < 1000; ++id) {
+        search_server.AddDocument(id, "cat dog"s + (id % 2 == 0 ? " parrot"s : ""s), DocumentStatus::ACTUAL, { 1 });
+    }
+    ASSERT(search_server.GetPostingMemoryUsage() > 0u);
+    ASSERT(search_server.GetPostingMemoryUsage() < 2500u * 16);
+}
+
+void TestQueryScratchReuse() {
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "white cat and collar"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.AddDocument(2, "black cat"s, DocumentStatus::ACTUAL, { 2 });
+    search_server.AddDocument(3, "black dog"s, DocumentStatus::ACTUAL, { 3 });
+
+    //      :       
+    ASSERT(search_server.FindTopDocuments("dog -cat"s).size() == 1u);
+    ASSERT_EQUAL(search_server.FindTopDocuments("cat"s).size(), 2u);
+    {
+        const auto [words, status] = search_server.MatchDocument(std::execution::par, "collar white white"s, 1);
+        ASSERT_EQUAL(words.size(), 2u);
+    }
+    {
+        const auto [words, status] = search_server.MatchDocument("black"s, 2);
+        ASSERT_EQUAL(words.size(), 1u);
+        ASSERT_EQUAL(words[0], "black"s);
+    }
+
+    //              
+    const auto documents = search_server.FindTopDocuments("black -white"s, [&](int document_id, DocumentStatus, int) {
+        const auto [words, _] = search_server.MatchDocument("cat -collar"s, document_id);
+        return !words.empty();
+        });
+    ASSERT_EQUAL(documents.size(), 1u);
+    ASSERT_EQUAL(documents[0].id, 2);
+
+    //      ,      
+    try {
+        search_server.FindTopDocuments("cat --dog"s);
+        ASSERT(false);
+    }
+    catch (const std::invalid_argument&) {
+    }
+    ASSERT_EQUAL(search_server.FindTopDocuments("collar"s).size(), 1u);
+}
+
+void TestSplitIntoValidWords() {
+    //     
+    const auto split_reference = [](const string& text) {
+        vector<string> words;
+        string word;
+        for (const char c : text) {
+            if (c == ' ') {
+                if (!word.empty()) {
+                    words.push_back(word);
+                }
+                word.clear();
+            }
+            else {
+                word += c;
+            }
+        }
+        if (!word.empty()) {
+            words.push_back(word);
+        }
+        return words;
+    };
+
+    //   ,        
+    const string alphabet = "ab \xE0\xFF  cd"s;
+    vector<string_view> words;
+    for (size_t length = 0; length < 300; ++length) {
+        string text;
+        for (size_t i = 0; i < length; ++i) {
+            text += alphabet[(i * 7 + length) % alphabet.size()];
+        }
+        const vector<string> expected = split_reference(text);
+        ASSERT(SplitIntoValidWords(text, words));
+        ASSERT_EQUAL(words.size(), expected.size());
+        for (size_t i = 0; i < words.size(); ++i) {
+            ASSERT_EQUAL(string(words[i]), expected[i]);
+        }
+        ASSERT_EQUAL(SplitIntoWords(text).size(), expected.size());
+    }
+
+    //        ,     0x80 
+    for (size_t position = 0; position < 200; position += 13) {
+        string text(200, 'x');
+        text[position] = '\x1F';
+        ASSERT(!SplitIntoValidWords(text, words));
+        ASSERT(ContainsControlCharacters(text));
+        text[position] = '\x80';
+        ASSERT(SplitIntoValidWords(text, words));
+        ASSERT(!ContainsControlCharacters(text));
+    }
+    ASSERT(ContainsControlCharacters("cat\0dog"sv));
+    ASSERT_EQUAL(SplitIntoWords("cat\x01 dog"s).size(), 2u);
+}
+
+void TestAddDocuments() {
+    const vector<string> texts = { "white cat and collar"s, "black cat"s, "black dog and collar"s, "and"s, "grey cat cat cat"s };
+    vector<DocumentToAdd> batch;
+    SearchServer expected_server("and"s);
+    for (int i = 0; i < static_cast<int>(texts.size()); ++i) {
+        batch.push_back({ i * 10, texts[i], i % 2 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, { i, i + 1 } });
+        expected_server.AddDocument(i * 10, texts[i], batch.back().status, batch.back().ratings);
+    }
+
+    //       ,     
+    auto thread_pool = std::make_shared<ThreadPool>(3);
+    for (const bool is_parallel : { false, true }) {
+        SearchServer search_server("and"s);
+        search_server.SetThreadPool(thread_pool);
+        search_server.AddDocument(1000, "old cat"s, DocumentStatus::ACTUAL, { 5 });
+        expected_server.AddDocument(1000, "old cat"s, DocumentStatus::ACTUAL, { 5 });
+        is_parallel ? search_server.AddDocuments(std::execution::par, batch) : search_server.AddDocuments(std::execution::seq, batch);
+        ASSERT_EQUAL(search_server.GetDocumentCount(), texts.size() + 1);
+        for (const string& query : { "cat"s, "black collar -dog"s, "grey old"s }) {
+            const auto expected = expected_server.FindTopDocuments(query, [](int, DocumentStatus, int) { return true; });
+            const auto documents = search_server.FindTopDocuments(query, [](int, DocumentStatus, int) { return true; });
+            ASSERT_EQUAL(documents.size(), expected.size());
+            for (size_t i = 0; i < documents.size(); ++i) {
+                ASSERT_EQUAL(documents[i].id, expected[i].id);
+                ASSERT_EQUAL(documents[i].rating, expected[i].rating);
+                ASSERT(std::abs(documents[i].relevance - expected[i].relevance) < INACCURACY);
+            }
+        }
+        ASSERT_EQUAL(search_server.GetWordFrequencies(40).at("cat"), 0.75);
+        ASSERT(search_server.GetWordFrequencies(30).empty());
+        expected_server.RemoveDocument(1000);
+    }
+
+    //        
+    SearchServer search_server("and"s);
+    search_server.AddDocument(7, "cat"s, DocumentStatus::ACTUAL, { 1 });
+    const vector<vector<DocumentToAdd>> bad_batches = {
+        { { 1, "dog", DocumentStatus::ACTUAL, { 1 } }, { -1, "rat", DocumentStatus::ACTUAL, { 1 } } },
+        { { 1, "dog", DocumentStatus::ACTUAL, { 1 } }, { 7, "rat", DocumentStatus::ACTUAL, { 1 } } },
+        { { 1, "dog", DocumentStatus::ACTUAL, { 1 } }, { 2, "rat", DocumentStatus::ACTUAL, { 1 } }, { 1, "pet", DocumentStatus::ACTUAL, { 1 } } },
+        { { 1, "dog", DocumentStatus::ACTUAL, { 1 } }, { 2, "r\x12t", DocumentStatus::ACTUAL, { 1 } } },
+    };
+    for (const auto& bad_batch : bad_batches) {
+        for (const bool is_parallel : { false, true }) {
+            try {
+                is_parallel ? search_server.AddDocuments(std::execution::par, bad_batch) : search_server.AddDocuments(std::execution::seq, bad_batch);
+                ASSERT(false);
+            }
+            catch (const std::invalid_argument&) {
+            }
+            ASSERT_EQUAL(search_server.GetDocumentCount(), 1u);
+            ASSERT(search_server.FindTopDocuments("dog"s).empty());
+        }
+    }
+}
+
+void TestSnapshot() {
+    const string path = (std::filesystem::temp_directory_path() / "search_server_test.snapshot").string();
+    SearchServer search_server("and in"s);
+    search_server.AddDocument(4, "white cat and fancy collar"s, DocumentStatus::ACTUAL, { 8, -3 });
+    search_server.AddDocument(1, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, { 7, 2, 7 });
+    search_server.AddDocument(9, "groomed dog expressive eyes"s, DocumentStatus::BANNED, { 5, -12, 2, 1 });
+    search_server.AddDocument(2, "groomed starling evgeny"s, DocumentStatus::ACTUAL, { 9 });
+    search_server.RemoveDocument(1);
+    search_server.SaveSnapshot(path);
+
+    const auto check_same = [](const SearchServer& expected_server, const SearchServer& loaded_server) {
+        ASSERT_EQUAL(loaded_server.GetDocumentCount(), expected_server.GetDocumentCount());
+        for (const string& query : { "fluffy groomed cat"s, "cat -collar"s, "in and"s, "groomed eyes"s }) {
+            const auto expected = expected_server.FindTopDocuments(query, [](int, DocumentStatus, int) { return true; });
+            const auto documents = loaded_server.FindTopDocuments(std::execution::par, query, [](int, DocumentStatus, int) { return true; });
+            ASSERT_EQUAL(documents.size(), expected.size());
+            for (size_t i = 0; i < documents.size(); ++i) {
+                ASSERT_EQUAL(documents[i].id, expected[i].id);
+                ASSERT_EQUAL(documents[i].rating, expected[i].rating);
+                ASSERT_EQUAL(documents[i].relevance, expected[i].relevance);
+            }
+        }
+        const auto [words, status] = loaded_server.MatchDocument("groomed dog tail"s, 9);
+        ASSERT_EQUAL(words.size(), 2u);
+        ASSERT(status == DocumentStatus::BANNED);
+        ASSERT(loaded_server.GetWordFrequencies(4) == expected_server.GetWordFrequencies(4));
+    };
+
+    SearchServer loaded_server = SearchServer::LoadSnapshot(path);
+    check_same(search_server, loaded_server);
+    ASSERT(loaded_server.GetWordFrequencies(1).empty());
+    // -  
+    ASSERT_EQUAL(loaded_server.GetWordFrequencies(4).count("and"), 0u);
+    ASSERT_EQUAL(vector<int>(loaded_server.begin(), loaded_server.end()), (vector<int>{ 4, 9, 2 }));
+
+    //        ,  
+    const SearchServer copy = loaded_server;
+    loaded_server.AddDocument(1, "fluffy cat with new words"s, DocumentStatus::ACTUAL, { 1 });
+    loaded_server.RemoveDocument(std::execution::par, 4);
+    search_server.AddDocument(1, "fluffy cat with new words"s, DocumentStatus::ACTUAL, { 1 });
+    search_server.RemoveDocument(4);
+    check_same(search_server, loaded_server);
+    check_same(SearchServer::LoadSnapshot(path), copy);
+
+    const auto expect_error = [](const string& bad_path, SnapshotVerification verification = SnapshotVerification::FULL) {
+        try {
+            SearchServer::LoadSnapshot(bad_path, verification);
+            ASSERT(false);
+        }
+        catch (const std::runtime_error&) {
+        }
+    };
+    //          STRUCTURE,      
+    {
+        //  - 24    24   : ,    
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekg(24 + 24 * static_cast<int>(SnapshotSection::DOCUMENT_TERMS));
+        uint64_t terms_offset = 0;
+        file.read(reinterpret_cast<char*>(&terms_offset), sizeof(terms_offset));
+        const uint32_t bad_term_id = 1000;
+        file.seekp(static_cast<std::streamoff>(terms_offset));
+        file.write(reinterpret_cast<const char*>(&bad_term_id), sizeof(bad_term_id));
+    }
+    expect_error(path, SnapshotVerification::STRUCTURE);
+
+    // ,      
+    search_server.SaveSnapshot(path);
+    {
+        //  16   -   
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(-16, std::ios::end);
+        file.put('#');
+    }
+    expect_error(path);
+    std::filesystem::resize_file(path, 100);
+    expect_error(path);
+    std::filesystem::remove(path);
+    expect_error(path);
 }
 
 void TestProcessQueries() {
@@ -515,6 +1682,206 @@ void TestProcessQueries() {
     }
 }
 
+void TestConcurrentSearchServer() {
+    SearchServer initial_server("and"s);
+    //  ,         
+    initial_server.SetSegmentCapacity(8);
+    ConcurrentSearchServer server(std::move(initial_server));
+    const auto empty_version = server.GetVersion();
+    std::atomic<bool> writer_done = false;
+    std::atomic<int> read_count = 0;
+    const auto read = [&] {
+        while (!writer_done.load() || read_count.load() < 100) {
+            //      id  id ^ 1,        
+            const auto version = server.GetVersion();
+            const size_t document_count = version->GetDocumentCount();
+            ASSERT(document_count % 2 == 0);
+            for (const Document& document : version->FindTopDocuments("pair"s)) {
+                ASSERT(!version->GetWordFrequencies(document.id ^ 1).empty());
+            }
+            ASSERT(server.FindTopDocuments("pair and cat"s).size() <= static_cast<size_t>(MAX_RESULT_DOCUMENT_COUNT));
+            ASSERT_EQUAL(version->GetDocumentCount(), document_count);
+            ++read_count;
+        }
+    };
+    vector<thread> readers;
+    for (int i = 0; i < 3; ++i) {
+        readers.emplace_back(read);
+    }
+    for (int pair = 0; pair < 300; ++pair) {
+        server.Modify([pair](SearchServer& search_server) {
+            search_server.AddDocument(2 * pair, "pair and cat"s, DocumentStatus::ACTUAL, { 1 });
+            search_server.AddDocument(2 * pair + 1, "pair and dog"s, DocumentStatus::ACTUAL, { 2 });
+            });
+        if (pair % 3 == 2) {
+            server.Modify([pair](SearchServer& search_server) {
+                search_server.RemoveDocument(2 * (pair - 1));
+                search_server.RemoveDocument(2 * (pair - 1) + 1);
+                });
+        }
+    }
+    writer_done = true;
+    for (thread& reader : readers) {
+        reader.join();
+    }
+    ASSERT_EQUAL(server.GetDocumentCount(), 400u);
+    server.WaitForSegmentMerge();
+    ASSERT(!server.GetVersion()->IsSegmentMergeNeeded());
+    ASSERT_EQUAL(server.FindTopDocuments("pair"s, [](int, DocumentStatus, int) { return true; }, 0, 1000).size(), 400u);
+    ASSERT_EQUAL(empty_version->GetDocumentCount(), 0u);
+    ASSERT(empty_version->FindTopDocuments("pair"s).empty());
+    //    
+    try {
+        server.Modify([](SearchServer& search_server) {
+            search_server.AddDocument(1000, "pair"s, DocumentStatus::ACTUAL, { 1 });
+            search_server.AddDocument(0, "pair"s, DocumentStatus::ACTUAL, { 1 });
+            });
+        ASSERT(false);
+    }
+    catch (const std::invalid_argument&) {
+    }
+    ASSERT_EQUAL(server.GetDocumentCount(), 400u);
+    server.RemoveDocument(0);
+    server.AddDocuments({ { 1000, "pair and bird", DocumentStatus::ACTUAL, { 3 } } });
+    ASSERT_EQUAL(server.GetDocumentCount(), 400u);
+}
+
+void TestSegments() {
+    const vector<string> texts = {
+        "white cat and fancy collar"s, "fluffy cat fluffy tail"s, "groomed dog expressive eyes"s,
+        "groomed starling eugene"s, "white dog with black tail"s, "cat and dog"s, "fancy starling"s,
+        "black cat"s, "eugene the dog"s, "fluffy fancy collar"s, "expressive cat eyes"s,
+    };
+    //           ,   
+    SearchServer reference("and with the"s);
+    SearchServer segmented("and with the"s);
+    segmented.SetSegmentCapacity(2);
+    SearchServer unmerged("and with the"s);
+    unmerged.SetAutoMergeSegments(false);
+    unmerged.SetSegmentCapacity(2);
+    for (int round = 0; round < 3; ++round) {
+        for (size_t index = 0; index < texts.size(); ++index) {
+            const int id = round * 100 + static_cast<int>(index);
+            for (SearchServer* server : { &reference, &segmented, &unmerged }) {
+                server->AddDocument(id, texts[index], DocumentStatus::ACTUAL, { id });
+            }
+        }
+        for (SearchServer* server : { &reference, &segmented, &unmerged }) {
+            server->RemoveDocument(round * 100 + 3);
+            server->RemoveDocument(std::execution::par, round * 100 + 8);
+        }
+    }
+    ASSERT_EQUAL(reference.GetSegmentCount(), 1u);
+    ASSERT(segmented.GetSegmentCount() > 1u);
+    ASSERT(segmented.GetSegmentCount() < unmerged.GetSegmentCount());
+
+    const auto expect_same_results = [&](const SearchServer& server, const SearchServer& reference) {
+        ASSERT_EQUAL(server.GetDocumentCount(), reference.GetDocumentCount());
+        for (const string& query : { "cat"s, "fluffy fancy dog -black"s, "starling eugene eyes"s, "groomed -starling"s }) {
+            const auto expected = reference.FindTopDocuments(query, [](int, DocumentStatus, int) { return true; }, 0, 100);
+            for (const auto& found : {
+                server.FindTopDocuments(query, [](int, DocumentStatus, int) { return true; }, 0, 100),
+                server.FindTopDocuments(std::execution::par, query, [](int, DocumentStatus, int) { return true; }, 0, 100) }) {
+                ASSERT_EQUAL(found.size(), expected.size());
+                for (size_t index = 0; index < found.size(); ++index) {
+                    ASSERT_EQUAL(found[index].id, expected[index].id);
+                    ASSERT_EQUAL(found[index].relevance, expected[index].relevance);
+                }
+            }
+        }
+        for (const int id : { 1, 105, 210 }) {
+            ASSERT(get<0>(server.MatchDocument("fluffy cat eyes -collar"s, id)) == get<0>(reference.MatchDocument("fluffy cat eyes -collar"s, id)));
+        }
+    };
+    expect_same_results(segmented, reference);
+    expect_same_results(unmerged, reference);
+
+    // ,    ,  ,   
+    {
+        SearchServer server = unmerged;
+        auto merge = server.PrepareSegmentMerge();
+        auto stale_merge = server.PrepareSegmentMerge();
+        ASSERT(merge.has_value() && stale_merge.has_value());
+        server.RemoveDocument(200);
+        SearchServer expected = reference;
+        expected.RemoveDocument(200);
+        const size_t segment_count = server.GetSegmentCount();
+        ASSERT(server.ApplySegmentMerge(std::move(*merge)));
+        ASSERT(server.GetSegmentCount() < segment_count);
+        ASSERT(!server.ApplySegmentMerge(std::move(*stale_merge)));
+        expect_same_results(server, expected);
+        server.MergeSegments();
+        ASSERT(!server.IsSegmentMergeNeeded());
+        expect_same_results(server, expected);
+    }
+    expect_same_results(unmerged, reference);
+
+    //       
+    const string path = (std::filesystem::temp_directory_path() / "search_server_segments.snapshot").string();
+    segmented.SaveSnapshot(path);
+    SearchServer loaded = SearchServer::LoadSnapshot(path);
+    std::filesystem::remove(path);
+    expect_same_results(loaded, reference);
+}
+
+void TestCompaction() {
+    const vector<string> texts = {
+        "white cat and fancy collar"s, "fluffy cat fluffy tail"s, "groomed dog expressive eyes"s,
+        "groomed starling eugene"s, "white dog with black tail"s, "cat and dog"s, "fancy starling"s,
+    };
+    //       ,     ,   id
+    SearchServer search_server("and with"s);
+    search_server.SetSegmentCapacity(4);
+    search_server.SetCompactionThreshold(2.);
+    SearchServer live_only("and with"s);
+    vector<int> removed_ids;
+    vector<int> live_ids;
+    for (int id = 0; id < 28; ++id) {
+        search_server.AddDocument(id, texts[id % texts.size()], DocumentStatus::ACTUAL, { id });
+        if (id % 3 == 0) {
+            removed_ids.push_back(id);
+        }
+        else {
+            live_only.AddDocument(id, texts[id % texts.size()], DocumentStatus::ACTUAL, { id });
+            live_ids.push_back(id);
+        }
+    }
+    search_server.RemoveDocuments(removed_ids);
+    ASSERT_EQUAL(search_server.GetPendingRemovalCount(), removed_ids.size());
+    ASSERT_EQUAL(search_server.GetDocumentCount(), live_ids.size());
+    ASSERT(vector<int>(search_server.begin(), search_server.end()) == live_ids);
+
+    const auto expect_live_results = [&] {
+        for (const string& query : { "cat"s, "fancy dog -black"s, "groomed starling eyes"s }) {
+            const auto expected = live_only.FindTopDocuments(query, [](int, DocumentStatus, int) { return true; }, 0, 100);
+            const auto found = search_server.FindTopDocuments(query, [](int, DocumentStatus, int) { return true; }, 0, 100);
+            ASSERT_EQUAL(found.size(), expected.size());
+            for (size_t index = 0; index < found.size(); ++index) {
+                ASSERT_EQUAL(found[index].id, expected[index].id);
+                ASSERT_EQUAL(found[index].relevance, expected[index].relevance);
+            }
+        }
+    };
+    expect_live_results();
+    search_server.Compact();
+    ASSERT_EQUAL(search_server.GetPendingRemovalCount(), 0u);
+    ASSERT(vector<int>(search_server.begin(), search_server.end()) == live_ids);
+    expect_live_results();
+
+    //       
+    SearchServer threshold_server;
+    threshold_server.SetSegmentCapacity(8);
+    for (int id = 0; id < 8; ++id) {
+        threshold_server.AddDocument(id, texts[id % texts.size()], DocumentStatus::ACTUAL, { id });
+    }
+    threshold_server.RemoveDocument(0);
+    ASSERT_EQUAL(threshold_server.GetPendingRemovalCount(), 1u);
+    threshold_server.RemoveDocuments({ 1, 42 });
+    ASSERT_EQUAL(threshold_server.GetPendingRemovalCount(), 0u);
+    ASSERT_EQUAL(threshold_server.GetDocumentCount(), 6u);
+    ASSERT_EQUAL(*threshold_server.begin(), 2);
+}
+
 //  TestSearchServer      
 void TestSearchServer() {
     RUN_TEST(TestExcludeStopWordsFromAddedDocumentContent);
@@ -522,6 +1889,8 @@ void TestSearchServer() {
     RUN_TEST(TestExcludeDocumentsWithMinusWords);
     RUN_TEST(TestMatchingDocument);
     RUN_TEST(TestParallelMatchingDocument);
+    RUN_TEST(TestMatchDocuments);
+    RUN_TEST(TestMatchDocumentTermIntersection);
     RUN_TEST(TestSortByRelevance);
     RUN_TEST(TestComputeAverageRating);
     RUN_TEST(TestFindTopDocumentByPredicate);
@@ -531,7 +1900,29 @@ void TestSearchServer() {
     RUN_TEST(TestCalculateRelevance);
     //RUN_TEST(TestGetDocumentId);
     RUN_TEST(TestRequestQueue);
+    RUN_TEST(TestRequestStatistics);
+    RUN_TEST(TestResultCache);
     RUN_TEST(TestRemoveDuplicates);
+    RUN_TEST(TestNearDuplicates);
+    RUN_TEST(TestRemoveDocument);
+    RUN_TEST(TestSparseDocumentIds);
+    RUN_TEST(TestTopDocuments);
+    RUN_TEST(TestFindTopDocumentsWindow);
+    RUN_TEST(TestScoreAccumulatorReuse);
+    RUN_TEST(TestParallelFindTopDocumentsMatchesSequential);
+    RUN_TEST(TestMaxScore);
+    RUN_TEST(TestThreadPool);
+    RUN_TEST(TestCachedInverseDocumentFreq);
+    RUN_TEST(TestTermDictionary);
+    RUN_TEST(TestPersistentArray);
+    RUN_TEST(TestPostingList);
+    RUN_TEST(TestQueryScratchReuse);
+    RUN_TEST(TestSplitIntoValidWords);
+    RUN_TEST(TestAddDocuments);
+    RUN_TEST(TestSnapshot);
     RUN_TEST(TestProcessQueries);
+    RUN_TEST(TestSegments);
+    RUN_TEST(TestCompaction);
+    RUN_TEST(TestConcurrentSearchServer);
 }
 
@@ -4,6 +4,8 @@ void TestExcludeStopWordsFromAddedDocumentContent();
 void TestGetWordFrequencies();
 void TestExcludeDocumentsWithMinusWords();
 void TestMatchingDocument();
+void TestMatchDocuments();
+void TestMatchDocumentTermIntersection();
 void TestSortByRelevance();
 void TestComputeAverageRating();
 void TestFindTopDocumentByPredicate();
@@ -13,8 +15,30 @@ void TestParallelFindTopDocumentByStatus();
 void TestCalculateRelevance();
 //void TestGetDocumentId();
 void TestRequestQueue();
+void TestRequestStatistics();
+void TestResultCache();
 void TestRemoveDuplicates();
+void TestNearDuplicates();
+void TestRemoveDocument();
+void TestSparseDocumentIds();
+void TestTopDocuments();
+void TestFindTopDocumentsWindow();
+void TestScoreAccumulatorReuse();
+void TestParallelFindTopDocumentsMatchesSequential();
+void TestMaxScore();
+void TestThreadPool();
+void TestCachedInverseDocumentFreq();
+void TestTermDictionary();
+void TestPersistentArray();
+void TestPostingList();
+void TestQueryScratchReuse();
+void TestSplitIntoValidWords();
+void TestAddDocuments();
+void TestSnapshot();
 void TestProcessQueries();
+void TestSegments();
+void TestCompaction();
+void TestConcurrentSearchServer();
 
 //  TestSearchServer      
 void TestSearchServer();
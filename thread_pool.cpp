@@ -0,0 +1,93 @@
+#include "thread_pool.h"
+
+namespace {
+
+//  ,    ,    - SIZE_MAX
+thread_local size_t current_worker_index = SIZE_MAX;
+thread_local const ThreadPool* current_pool = nullptr;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t thread_count) {
+    workers_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_[i]->thread = std::thread([this, i] { Run(i); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard guard(idle_mutex_);
+        stop_ = true;
+    }
+    idle_cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker->thread.join();
+    }
+}
+
+ThreadPool& ThreadPool::GetDefault() {
+    static ThreadPool pool;
+    return pool;
+}
+
+//       ,       
+void ThreadPool::Push(Task task) {
+    const size_t worker_index = current_pool == this
+        ? current_worker_index
+        : next_worker_++ % workers_.size();
+    {
+        std::lock_guard guard(workers_[worker_index]->mutex);
+        workers_[worker_index]->tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard guard(idle_mutex_);
+        ++pending_tasks_;
+    }
+    idle_cv_.notify_one();
+}
+
+//     (    ),  -  
+bool ThreadPool::TryPop(size_t worker_index, Task& task) {
+    for (size_t shift = 0; shift < workers_.size(); ++shift) {
+        Worker& worker = *workers_[(worker_index + shift) % workers_.size()];
+        std::lock_guard guard(worker.mutex);
+        if (worker.tasks.empty()) {
+            continue;
+        }
+        if (shift == 0) {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+        }
+        else {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+        }
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::Run(size_t worker_index) {
+    current_worker_index = worker_index;
+    current_pool = this;
+    while (true) {
+        {
+            std::unique_lock lock(idle_mutex_);
+            idle_cv_.wait(lock, [this] { return stop_ || pending_tasks_ > 0; });
+            if (pending_tasks_ == 0) {
+                return;
+            }
+            --pending_tasks_;
+        }
+        //     ,       
+        Task task;
+        while (!TryPop(worker_index, task)) {
+            std::this_thread::yield();
+        }
+        task();
+    }
+}
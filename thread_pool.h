@@ -0,0 +1,133 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+//     :      ,
+//       ,     
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t thread_count = std::thread::hardware_concurrency());
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+    ~ThreadPool();
+
+    //    std::thread::hardware_concurrency() ,    
+    static ThreadPool& GetDefault();
+
+    size_t GetThreadCount() const {
+        return workers_.size();
+    }
+
+    //   .         ,
+    //    ParallelFor
+    template <typename Function>
+    auto Submit(Function function) -> std::future<std::invoke_result_t<Function>>;
+
+    // function(index)   index  [0, count)      .
+    //        ,        .
+    //    
+    template <typename Function>
+    void ParallelFor(size_t count, Function&& function);
+
+private:
+    using Task = std::function<void()>;
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<size_t> next_worker_ = 0;
+
+    std::mutex idle_mutex_;
+    std::condition_variable idle_cv_;
+    size_t pending_tasks_ = 0;
+    bool stop_ = false;
+
+    void Push(Task task);
+    bool TryPop(size_t worker_index, Task& task);
+    void Run(size_t worker_index);
+};
+
+template <typename Function>
+auto ThreadPool::Submit(Function function) -> std::future<std::invoke_result_t<Function>> {
+    using Result = std::invoke_result_t<Function>;
+    auto task = std::make_shared<std::packaged_task<Result()>>(std::move(function));
+    std::future<Result> result = task->get_future();
+    if (workers_.empty()) {
+        (*task)();
+        return result;
+    }
+    Push([task] { (*task)(); });
+    return result;
+}
+
+template <typename Function>
+void ThreadPool::ParallelFor(size_t count, Function&& function) {
+    if (count == 0) {
+        return;
+    }
+    if (count == 1 || workers_.empty()) {
+        for (size_t index = 0; index < count; ++index) {
+            function(index);
+        }
+        return;
+    }
+
+    // ,       :   ,   ,
+    // ,    function
+    struct State {
+        std::atomic<size_t> next_index = 0;
+        std::atomic<size_t> done_count = 0;
+        size_t count = 0;
+        std::remove_reference_t<Function>* function = nullptr;
+        std::mutex mutex;
+        std::condition_variable done_cv;
+        std::exception_ptr exception;
+    };
+    auto state = std::make_shared<State>();
+    state->count = count;
+    state->function = &function;
+
+    const auto work = [](State& state) {
+        for (size_t index = state.next_index++; index < state.count; index = state.next_index++) {
+            try {
+                (*state.function)(index);
+            }
+            catch (...) {
+                std::lock_guard guard(state.mutex);
+                if (!state.exception) {
+                    state.exception = std::current_exception();
+                }
+            }
+            if (++state.done_count == state.count) {
+                std::lock_guard guard(state.mutex);
+                state.done_cv.notify_all();
+            }
+        }
+    };
+
+    const size_t helper_count = std::min(count - 1, workers_.size());
+    for (size_t i = 0; i < helper_count; ++i) {
+        Push([state, work] { work(*state); });
+    }
+    work(*state);
+
+    //   ,   ,    
+    std::unique_lock lock(state->mutex);
+    state->done_cv.wait(lock, [&] { return state->done_count == state->count; });
+    if (state->exception) {
+        std::rethrow_exception(state->exception);
+    }
+}
@@ -0,0 +1,54 @@
+#include "top_documents.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+bool IsMoreRelevant(const Document& lhs, const Document& rhs) {
+    if (std::abs(lhs.relevance - rhs.relevance) < INACCURACY) {
+        return lhs.rating > rhs.rating;
+    }
+    return lhs.relevance > rhs.relevance;
+}
+
+TopDocuments::TopDocuments(size_t top_count)
+    : top_count_(top_count)
+{
+}
+
+void TopDocuments::Add(const Document& document) {
+    if (heap_.size() < top_count_) {
+        heap_.push_back(document);
+        std::push_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+        return;
+    }
+    if (heap_.empty() || !IsMoreRelevant(document, heap_.front())) {
+        return;
+    }
+    std::pop_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+    heap_.back() = document;
+    std::push_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+}
+
+void TopDocuments::Merge(const TopDocuments& other) {
+    for (const Document& document : other.heap_) {
+        Add(document);
+    }
+}
+
+double TopDocuments::GetMinRelevance() const {
+    if (top_count_ == 0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    if (heap_.size() < top_count_) {
+        return -std::numeric_limits<double>::infinity();
+    }
+    return heap_.front().relevance - INACCURACY;
+}
+
+std::vector<Document> TopDocuments::Extract() {
+    std::sort_heap(heap_.begin(), heap_.end(), IsMoreRelevant);
+    std::vector<Document> result = std::move(heap_);
+    heap_.clear();
+    return result;
+}
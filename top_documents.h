@@ -0,0 +1,31 @@
+#pragma once
+#include <vector>
+
+#include "document.h"
+
+constexpr double INACCURACY = 1e-6;
+
+// :   ,   (  INACCURACY) -   
+bool IsMoreRelevant(const Document& lhs, const Document& rhs);
+
+// :       top_count ,
+//      ,      O(1)
+class TopDocuments {
+public:
+    explicit TopDocuments(size_t top_count);
+
+    void Add(const Document& document);
+
+    void Merge(const TopDocuments& other);
+
+    //,         :    INACCURACY.
+    //    -  
+    double GetMinRelevance() const;
+
+    //    ,    
+    std::vector<Document> Extract();
+
+private:
+    size_t top_count_ = 0;
+    std::vector<Document> heap_;
+};